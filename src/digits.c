@@ -0,0 +1,71 @@
+#include "digits.h"
+
+static GBitmap *s_atlas;
+static GBitmap *s_glyphs[DIGITS_GLYPH_COUNT];
+
+bool digits_load(uint32_t resource_id) {
+  s_atlas = gbitmap_create_with_resource(resource_id);
+  if(!s_atlas) {
+    return false;
+  }
+  for(int i=0; i<DIGITS_GLYPH_COUNT; i++) {
+    s_glyphs[i] = gbitmap_create_as_sub_bitmap(s_atlas, GRect(i*DIGITS_GLYPH_WIDTH, 0, DIGITS_GLYPH_WIDTH, DIGITS_GLYPH_HEIGHT));
+  }
+  return true;
+}
+
+void digits_unload() {
+  for(int i=0; i<DIGITS_GLYPH_COUNT; i++) {
+    if(s_glyphs[i]) {
+      gbitmap_destroy(s_glyphs[i]);
+      s_glyphs[i] = NULL;
+    }
+  }
+  if(s_atlas) {
+    gbitmap_destroy(s_atlas);
+    s_atlas = NULL;
+  }
+}
+
+//////////////////////////////////////////
+// blits one glyph per character,       //
+// centered like the text layers were   //
+//////////////////////////////////////////
+static void digits_update_proc(Layer *layer, GContext *ctx) {
+  const char *text = layer_get_data(layer);
+  GRect bounds = layer_get_bounds(layer);
+  int length = strlen(text);
+  if(!length) {
+    return;
+  }
+  int width = length * DIGITS_ADVANCE - (DIGITS_ADVANCE - DIGITS_GLYPH_WIDTH);
+  GRect glyph_rect = GRect((bounds.size.w - width) / 2, DIGITS_TOP, DIGITS_GLYPH_WIDTH, DIGITS_GLYPH_HEIGHT);
+  
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  for(int i=0; i<length; i++) {
+    int glyph = text[i] == '-' ? DIGITS_GLYPH_MINUS : text[i] - '0';
+    if(glyph >= 0 && glyph < DIGITS_GLYPH_COUNT && s_glyphs[glyph]) {
+      graphics_draw_bitmap_in_rect(ctx, s_glyphs[glyph], glyph_rect);
+    }
+    glyph_rect.origin.x += DIGITS_ADVANCE;
+  }
+}
+
+Layer *digits_layer_create(GRect frame) {
+  Layer *layer = layer_create_with_data(frame, DIGITS_MAX_LENGTH + 1);
+  if(layer) {
+    memset(layer_get_data(layer), 0, DIGITS_MAX_LENGTH + 1);
+    layer_set_update_proc(layer, digits_update_proc);
+  }
+  return layer;
+}
+
+void digits_layer_set_value(Layer *layer, int32_t value, uint8_t min_digits) {
+  char text[DIGITS_MAX_LENGTH + 1];
+  snprintf(text, sizeof(text), "%0*d", min_digits, (int)value);
+  char *current = layer_get_data(layer);
+  if(strcmp(text, current) != 0) {
+    strcpy(current, text);
+    layer_mark_dirty(layer);
+  }
+}
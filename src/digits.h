@@ -0,0 +1,28 @@
+#pragma once
+#include <pebble.h>
+
+//////////////////////////////////////////////////
+// numeric fields drawn from a pre-rendered     //
+// glyph atlas, no text layout involved         //
+// atlas cells are 0-9 then '-', left to right  //
+//////////////////////////////////////////////////
+#define DIGITS_GLYPH_WIDTH 5
+#define DIGITS_GLYPH_HEIGHT 9
+#define DIGITS_GLYPH_COUNT 11
+#define DIGITS_GLYPH_MINUS 10
+// glyph pitch, one blank column between digits
+#define DIGITS_ADVANCE 6
+// glyph top inside the layer, lines up with the Gothic 14 digits it replaced
+#define DIGITS_TOP 4
+// longest value, sign included
+#define DIGITS_MAX_LENGTH 7
+
+// slices the atlas into glyphs, false if it could not be loaded
+bool digits_load(uint32_t resource_id);
+void digits_unload();
+
+// layer drawing one number centered in its frame, blank until set
+Layer *digits_layer_create(GRect frame);
+
+// sets the number, zero padded to min_digits, redraws only if it changed
+void digits_layer_set_value(Layer *layer, int32_t value, uint8_t min_digits);
@@ -0,0 +1,65 @@
+#include "forecast.h"
+
+#define FORECAST_STORE_VERSION 1
+
+static Forecast s_forecast;
+
+bool forecast_decode(const uint8_t *data, uint16_t length) {
+  if(!data || length < FORECAST_HEADER_SIZE || data[0] != FORECAST_PROTOCOL_VERSION) {
+    return false;
+  }
+  uint8_t count = data[1];
+  if(count > FORECAST_MAX_HOURS || length != FORECAST_PAYLOAD_SIZE(count)) {
+    return false;
+  }
+  s_forecast.version = FORECAST_STORE_VERSION;
+  s_forecast.count = count;
+  s_forecast.head = 0;
+  s_forecast.start = (time_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8) | ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 24));
+  s_forecast.flags = data[6];
+  const uint8_t *hour = data + FORECAST_HEADER_SIZE;
+  for(int i=0; i<count; i++) {
+    s_forecast.temperature[i] = (int8_t)hour[0];
+    s_forecast.condition[i] = hour[1];
+    hour += FORECAST_HOUR_SIZE;
+  }
+  return true;
+}
+
+bool forecast_advance(time_t now) {
+  bool advanced = false;
+  while(s_forecast.count && now >= s_forecast.start + SECONDS_PER_HOUR) {
+    s_forecast.head = (s_forecast.head + 1) % FORECAST_MAX_HOURS;
+    s_forecast.count--;
+    s_forecast.start += SECONDS_PER_HOUR;
+    advanced = true;
+  }
+  return advanced;
+}
+
+bool forecast_current(WeatherReport *report) {
+  if(!s_forecast.count) {
+    return false;
+  }
+  report->observed = s_forecast.start;
+  report->temperature = s_forecast.temperature[s_forecast.head];
+  report->condition = s_forecast.condition[s_forecast.head];
+  report->flags = s_forecast.flags;
+  return true;
+}
+
+time_t forecast_end() {
+  return s_forecast.count ? s_forecast.start + s_forecast.count * SECONDS_PER_HOUR : 0;
+}
+
+void forecast_save() {
+  persist_write_data(PERSIST_KEY_FORECAST, &s_forecast, sizeof(s_forecast));
+}
+
+void forecast_restore() {
+  if(!persist_exists(PERSIST_KEY_FORECAST) ||
+     persist_read_data(PERSIST_KEY_FORECAST, &s_forecast, sizeof(s_forecast)) != (int)sizeof(s_forecast) ||
+     s_forecast.version != FORECAST_STORE_VERSION || s_forecast.count > FORECAST_MAX_HOURS) {
+    memset(&s_forecast, 0, sizeof(s_forecast));
+  }
+}
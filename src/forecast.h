@@ -0,0 +1,36 @@
+#pragma once
+#include <pebble.h>
+#include "protocol.h"
+
+///////////////////////////////////////////////////
+// hourly forecast ring buffer                   //
+// filled from one phone sync, advanced locally  //
+// every hour and persisted across launches      //
+///////////////////////////////////////////////////
+#define FORECAST_MAX_HOURS 24
+#define PERSIST_KEY_FORECAST 2
+
+typedef struct {
+  uint8_t version;
+  uint8_t count;                            // hours left, starting at head
+  uint8_t head;                             // ring index of the current hour
+  uint8_t flags;                            // WEATHER_FLAG_* of the whole forecast
+  time_t start;                             // start of the hour at head
+  int8_t temperature[FORECAST_MAX_HOURS];
+  uint8_t condition[FORECAST_MAX_HOURS];
+} Forecast;
+
+// replaces the buffer with a forecast payload, false if malformed
+bool forecast_decode(const uint8_t *data, uint16_t length);
+
+// drops hours that have passed, true if the current hour changed
+bool forecast_advance(time_t now);
+
+// current hour as a weather report, false if the forecast ran out
+bool forecast_current(WeatherReport *report);
+
+// end of the last forecast hour, 0 if empty
+time_t forecast_end();
+
+void forecast_save();
+void forecast_restore();
@@ -0,0 +1,102 @@
+#include "gauge.h"
+#include "geometry.h"
+
+/////////////////////////////////////////////////
+// value/max as a trig angle by long division, //
+// one bit at a time so nothing overflows 32   //
+// bits for any max, remainder is nonzero if   //
+// the angle was rounded down                  //
+/////////////////////////////////////////////////
+static int32_t gauge_angle_divide(int32_t value, int32_t max, bool *inexact) {
+  *inexact = false;
+  if(max <= 0 || value <= 0) {
+    return 0;
+  }
+  if(value >= max) {
+    return TRIG_MAX_ANGLE;
+  }
+  uint32_t remainder = value;
+  int32_t angle = 0;
+  for(int bit=0; bit<16; bit++) {
+    remainder <<= 1;
+    angle <<= 1;
+    if(remainder >= (uint32_t)max) {
+      remainder -= max;
+      angle |= 1;
+    }
+  }
+  *inexact = remainder != 0;
+  return angle;
+}
+
+int32_t gauge_angle_floor(int32_t value, int32_t max) {
+  bool inexact;
+  return gauge_angle_divide(value, max, &inexact);
+}
+
+int32_t gauge_angle_ceil(int32_t value, int32_t max) {
+  bool inexact;
+  int32_t angle = gauge_angle_divide(value, max, &inexact);
+  return inexact ? angle + 1 : angle;
+}
+
+//////////////////////////////////////////////
+// clears pixels x0..x1 of a 1-bit row, one //
+// 32-bit word at a time, LSB is leftmost   //
+//////////////////////////////////////////////
+static void gauge_clear_span(uint32_t *row, int x0, int x1) {
+  int first = x0 >> 5;
+  int last = x1 >> 5;
+  uint32_t head = ~0u << (x0 & 31);
+  uint32_t tail = ~0u >> (31 - (x1 & 31));
+  if(first == last) {
+    row[first] &= ~(head & tail);
+    return;
+  }
+  row[first] &= ~head;
+  for(int w=first+1; w<last; w++) {
+    row[w] = 0;
+  }
+  row[last] &= ~tail;
+}
+
+void gauge_fill(GContext *ctx, GRect bounds, int32_t angle_start, int32_t angle_end) {
+  // only the generated ring size inside a word aligned 1-bit frame
+  // buffer takes the span path, anything else goes through the firmware
+  GBitmap *frame_buffer = NULL;
+  if(bounds.size.w == GAUGE_DIAMETER && bounds.size.h == GAUGE_DIAMETER) {
+    frame_buffer = graphics_capture_frame_buffer(ctx);
+  }
+  uint8_t *data = frame_buffer ? gbitmap_get_data(frame_buffer) : NULL;
+  uint16_t row_bytes = frame_buffer ? gbitmap_get_bytes_per_row(frame_buffer) : 0;
+  GRect frame = frame_buffer ? gbitmap_get_bounds(frame_buffer) : GRectZero;
+  if(!frame_buffer || gbitmap_get_format(frame_buffer) != GBitmapFormat1Bit ||
+     (((uintptr_t)data | row_bytes) & 3) || bounds.origin.x < 0 || bounds.origin.y < 0 ||
+     bounds.origin.x + bounds.size.w > frame.size.w || bounds.origin.y + bounds.size.h > frame.size.h) {
+    if(frame_buffer) {
+      graphics_release_frame_buffer(ctx, frame_buffer);
+    }
+    graphics_fill_radial(ctx, bounds, GOvalScaleModeFitCircle, GAUGE_THICKNESS, angle_start, angle_end);
+    return;
+  }
+  
+  // angles are monotonic along a span, so the covered pixels are one run
+  for(int i=0; i<GAUGE_SPAN_COUNT; i++) {
+    const GaugeSpan *span = &GAUGE_SPAN_TABLE[i];
+    const uint16_t *angles = &GAUGE_SPAN_ANGLES[span->angle_index];
+    int first = -1, last = -1;
+    for(int x=0; x<=span->x1-span->x0; x++) {
+      if(angles[x] >= angle_start && angles[x] < angle_end) {
+        if(first < 0) {
+          first = x;
+        }
+        last = x;
+      }
+    }
+    if(first >= 0) {
+      uint32_t *row = (uint32_t *)(data + (bounds.origin.y + span->y) * row_bytes);
+      gauge_clear_span(row, bounds.origin.x + span->x0 + first, bounds.origin.x + span->x0 + last);
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
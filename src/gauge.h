@@ -0,0 +1,20 @@
+#pragma once
+#include <pebble.h>
+
+//////////////////////////////////////////////////
+// fixed-point helpers for the radial gauges    //
+// all math is integer, diorite has no FPU      //
+//////////////////////////////////////////////////
+#define GAUGE_DIAMETER 36
+#define GAUGE_THICKNESS 2
+
+// portion of a full turn covered by value/max, rounded down
+int32_t gauge_angle_floor(int32_t value, int32_t max);
+
+// portion of a full turn covered by value/max, rounded up
+int32_t gauge_angle_ceil(int32_t value, int32_t max);
+
+// fills the ring inside bounds between two trig angles in black, bounds
+// are frame buffer coordinates so the layer must sit at the screen
+// origin, GAUGE_DIAMETER rings are written straight as spans
+void gauge_fill(GContext *ctx, GRect bounds, int32_t angle_start, int32_t angle_end);
@@ -0,0 +1,44 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// pre-rotated hand and tick geometry            //
+// tables are generated by wscript at build time //
+// all points are offsets from the dial center   //
+///////////////////////////////////////////////////
+#define MINUTE_POSITIONS 60
+#define SECOND_POSITIONS 60
+#define HOUR_POSITIONS 72
+#define TICK_POSITIONS 60
+#define HAND_POINTS 5
+#define FILLER_POINTS 4
+
+extern const GPoint MINUTE_HAND_TABLE[MINUTE_POSITIONS][HAND_POINTS];
+extern const GPoint MINUTE_FILLER_TABLE[MINUTE_POSITIONS][FILLER_POINTS];
+extern const GPoint HOUR_HAND_TABLE[HOUR_POSITIONS][HAND_POINTS];
+extern const GPoint HOUR_FILLER_TABLE[HOUR_POSITIONS][FILLER_POINTS];
+
+// seconds hand tail and tip points
+extern const GPoint SECOND_HAND_TABLE[SECOND_POSITIONS][2];
+
+// tick start (inner) and end (outer) points
+extern const GPoint TICK_TABLE[TICK_POSITIONS][2];
+
+// step bar points, [hour][0] is the inner end and [hour][length] the
+// outer end of a bar that many pixels long
+#define STEP_BAR_POSITIONS 12
+#define STEP_BAR_MAX_LENGTH 7
+extern const GPoint STEP_BAR_TABLE[STEP_BAR_POSITIONS][STEP_BAR_MAX_LENGTH + 1];
+
+// GAUGE_DIAMETER ring split into half row spans, the clockwise angle of
+// each pixel from x0 to x1 is stored from angle_index on, see src/gauge.c
+typedef struct {
+  uint8_t y;
+  uint8_t x0;
+  uint8_t x1;
+  uint16_t angle_index;
+} GaugeSpan;
+
+extern const uint16_t GAUGE_SPAN_COUNT;
+extern const GaugeSpan GAUGE_SPAN_TABLE[];
+extern const uint16_t GAUGE_SPAN_ANGLES[];
@@ -0,0 +1,72 @@
+#include "histogram.h"
+
+static StepHour s_buckets[HISTOGRAM_HOURS];
+static time_t s_read_until;
+
+// bucket of the hour containing t, reset if it still holds an older hour
+static StepHour *histogram_bucket(time_t t) {
+  struct tm *local = localtime(&t);
+  time_t start = t - local->tm_min * SECONDS_PER_MINUTE - local->tm_sec;
+  StepHour *bucket = &s_buckets[local->tm_hour % HISTOGRAM_HOURS];
+  if(bucket->start != start) {
+    bucket->start = start;
+    bucket->steps = 0;
+  }
+  return bucket;
+}
+
+void histogram_init(time_t now) {
+  memset(s_buckets, 0, sizeof(s_buckets));
+  time_t hour_start = histogram_bucket(now)->start;
+  for(int i=1; i<HISTOGRAM_HOURS; i++) {
+    time_t start = hour_start - i * SECONDS_PER_HOUR;
+    histogram_bucket(start)->steps = health_service_sum(HealthMetricStepCount, start, start + SECONDS_PER_HOUR);
+  }
+  s_read_until = hour_start;
+  histogram_update(now);
+}
+
+bool histogram_update(time_t now) {
+  // a long pause only needs the hours still on the dial
+  time_t oldest = now - (HISTOGRAM_HOURS - 1) * SECONDS_PER_HOUR;
+  if(s_read_until < oldest) {
+    s_read_until = oldest;
+  }
+  
+  bool changed = false;
+  HealthMinuteData minutes[HISTOGRAM_CHUNK_MINUTES];
+  while(s_read_until < now) {
+    time_t start = s_read_until;
+    time_t end = MIN(now, start + HISTOGRAM_CHUNK_MINUTES * SECONDS_PER_MINUTE);
+    uint32_t count = health_service_get_minute_history(minutes, HISTOGRAM_CHUNK_MINUTES, &start, &end);
+    // history lags a few minutes behind, stop at what has been recorded
+    if(!count || end <= s_read_until) {
+      break;
+    }
+    for(uint32_t i=0; i<count; i++) {
+      if(!minutes[i].is_invalid && minutes[i].steps) {
+        histogram_bucket(start + i * SECONDS_PER_MINUTE)->steps += minutes[i].steps;
+        changed = true;
+      }
+    }
+    s_read_until = end;
+  }
+  return changed;
+}
+
+void histogram_load(const StepHour hours[HISTOGRAM_HOURS], time_t updated) {
+  memcpy(s_buckets, hours, sizeof(s_buckets));
+  s_read_until = updated;
+}
+
+void histogram_set_hour(time_t t, uint32_t steps) {
+  histogram_bucket(t)->steps = steps;
+}
+
+uint32_t histogram_steps(int position, time_t now) {
+  const StepHour *bucket = &s_buckets[position % HISTOGRAM_HOURS];
+  if(now - bucket->start >= HISTOGRAM_HOURS * SECONDS_PER_HOUR) {
+    return 0;
+  }
+  return bucket->steps;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <pebble.h>
+#include "worker_shared.h"
+
+//////////////////////////////////////////////////
+// hourly step buckets for the last 12 hours,   //
+// one per clock position, fed incrementally    //
+// from minute history so each update only      //
+// reads the minutes recorded since the last    //
+//////////////////////////////////////////////////
+#define HISTOGRAM_HOURS WORKER_HOURS
+// minutes of history read per call, bounds the stack buffer
+#define HISTOGRAM_CHUNK_MINUTES 15
+
+// fills the past hours with one sum each and reads the current hour
+void histogram_init(time_t now);
+
+// reads minutes recorded since the last update, true if any bucket grew
+bool histogram_update(time_t now);
+
+// replaces all buckets with hours aggregated by the worker, minute
+// history is read again from updated onwards
+void histogram_load(const StepHour hours[HISTOGRAM_HOURS], time_t updated);
+
+// sets the hour containing t to a total counted by the worker
+void histogram_set_hour(time_t t, uint32_t steps);
+
+// steps in the hour shown at a clock position (0-11), 0 if older than 12h
+uint32_t histogram_steps(int position, time_t now);
@@ -1,52 +1,388 @@
 var myAPIKey = '';
 
-var xhrRequest = function (url, type, callback) {
+// compact weather payload, must match src/protocol.h
+var WEATHER_PROTOCOL_VERSION = 1;
+var WEATHER_FLAG_FAHRENHEIT = 1 << 0;
+var WEATHER_CONDITION_UNKNOWN = 0xFF;
+var FORECAST_PROTOCOL_VERSION = 1;
+// hours of forecast sent per sync, the watch rings at most 24
+var FORECAST_HOURS = 24;
+
+// Dark Sky icon names mapped to watch condition codes
+var CONDITION_CODES = {
+  'clear-day': 0,
+  'clear-night': 1,
+  'rain': 2,
+  'snow': 3,
+  'sleet': 4,
+  'wind': 5,
+  'fog': 6,
+  'cloudy': 7,
+  'partly-cloudy-day': 8,
+  'partly-cloudy-night': 9
+};
+
+// forecast endpoint, point at a local stub server for testing
+var FORECAST_BASE_URL = 'https://api.forecast.io/forecast/';
+
+// cached forecasts are reused for this long before refetching
+var CACHE_TTL_MS = 15 * 60 * 1000;
+// older copies are too stale to show while refetching and are pruned
+var CACHE_MAX_AGE_MS = 6 * 60 * 60 * 1000;
+// lat/lon are snapped to a grid of this many degrees (about 5km)
+var CACHE_GRID_DEGREES = 0.05;
+var CACHE_KEY_PREFIX = 'forecast:';
+
+// daily step goal sent to the watch, unset keeps the watch's own goal
+var STEP_GOAL_KEY = 'stepGoal';
+// quiet hours (0-23) when the watch drops to low power, unset or equal disables
+var QUIET_START_KEY = 'quietStartHour';
+var QUIET_END_KEY = 'quietEndHour';
+// seconds the phone may be gone before the watch buzzes, unset keeps the watch default
+var DISCONNECT_GRACE_KEY = 'disconnectGraceSeconds';
+// minutes between weather refreshes, unset keeps the watch default
+var REFRESH_INTERVAL_KEY = 'refreshIntervalMinutes';
+// set to '1' to have the watch dump its profiling counters on launch
+var PROFILE_KEY = 'profileOnReady';
+// dump layout, must match src/profile.h
+var PROFILE_DUMP_VERSION = 6;
+var PROFILE_SLOT_NAMES = ['dial', 'hands', 'battery', 'health'];
+var PROFILE_EVENT_NAMES = ['tick', 'health', 'worker', 'battery', 'bluetooth', 'tap', 'button', 'inbox', 'outbox', 'vibe'];
+var PROFILE_ENERGY_NAMES = ['render', 'wakeup', 'radio', 'vibe'];
+
+// callbacks waiting on an in-flight request, keyed by grid cell
+var pendingRequests = {};
+
+// messages to the watch go out one at a time, a NACKed message is
+// retried with exponential backoff up to this many times
+var SEND_MAX_ATTEMPTS = 5;
+var SEND_RETRY_BASE_MS = 1000;
+var SEND_RETRY_MAX_MS = 30000;
+// unsent messages in order, at most one per kind
+var sendQueue = [];
+var sendInFlight = null;
+var sendRetryTimer = null;
+
+// a request with no answer after this long counts as failed
+var XHR_TIMEOUT_MS = 20000;
+
+var xhrRequest = function (url, type, callback, errorCallback) {
   var xhr = new XMLHttpRequest();
+  var fail = function () {
+    if (errorCallback) {
+      errorCallback();
+    }
+  };
   xhr.onload = function () {
+    // error pages arrive through onload too
+    if (this.status < 200 || this.status >= 300) {
+      console.log("Request failed with status " + this.status);
+      fail();
+      return;
+    }
     callback(this.responseText);
   };
+  xhr.onerror = fail;
+  xhr.ontimeout = fail;
   xhr.open(type, url);
+  xhr.timeout = XHR_TIMEOUT_MS;
   xhr.send();
 };
 
+// queues a message for the watch, a newer message of the same kind
+// replaces an unsent older one instead of queueing behind it
+function queueMessage(kind, dictionary, onGiveUp) {
+  var message = {kind: kind, dictionary: dictionary, onGiveUp: onGiveUp, attempts: 0};
+  for (var i = 0; i < sendQueue.length; i++) {
+    if (sendQueue[i].kind === kind) {
+      console.log("Replacing unsent " + kind + " message");
+      sendQueue[i] = message;
+      return;
+    }
+  }
+  sendQueue.push(message);
+  pumpQueue();
+}
+
+function hasQueued(kind) {
+  return sendQueue.some(function (message) {
+    return message.kind === kind;
+  });
+}
+
+// sends the next message once the previous one is ACKed or given up on
+function pumpQueue() {
+  if (sendInFlight || sendRetryTimer || !sendQueue.length) {
+    return;
+  }
+  var message = sendInFlight = sendQueue.shift();
+  message.attempts++;
+  Pebble.sendAppMessage(message.dictionary,
+    function (e) {
+      console.log("Sent " + message.kind + " to Pebble successfully!");
+      sendInFlight = null;
+      pumpQueue();
+    },
+    function (e) {
+      sendInFlight = null;
+      if (hasQueued(message.kind)) {
+        // superseded while in flight, the newer one goes instead
+        pumpQueue();
+        return;
+      }
+      if (message.attempts >= SEND_MAX_ATTEMPTS) {
+        console.log("Giving up sending " + message.kind + " to Pebble!");
+        if (message.onGiveUp) {
+          message.onGiveUp();
+        }
+        pumpQueue();
+        return;
+      }
+      var delay = Math.min(SEND_RETRY_BASE_MS << (message.attempts - 1), SEND_RETRY_MAX_MS);
+      console.log("Error sending " + message.kind + " to Pebble, retrying in " + delay + "ms");
+      sendQueue.unshift(message);
+      sendRetryTimer = setTimeout(function () {
+        sendRetryTimer = null;
+        pumpQueue();
+      }, delay);
+    }
+  );
+}
+
+// snaps a coordinate to the cache grid
+function quantize(value) {
+  return (Math.round(value / CACHE_GRID_DEGREES) * CACHE_GRID_DEGREES).toFixed(2);
+}
+
+function readCache(cell) {
+  try {
+    return JSON.parse(localStorage.getItem(CACHE_KEY_PREFIX + cell));
+  } catch (e) {
+    return null;
+  }
+}
+
+// drops expired forecasts for every cell so moving around does not
+// fill localStorage
+function pruneCache() {
+  var expired = [];
+  for (var i = 0; i < localStorage.length; i++) {
+    var key = localStorage.key(i);
+    if (key && key.indexOf(CACHE_KEY_PREFIX) === 0) {
+      var entry = readCache(key.substring(CACHE_KEY_PREFIX.length));
+      if (!entry || !(Date.now() - entry.fetched < CACHE_MAX_AGE_MS)) {
+        expired.push(key);
+      }
+    }
+  }
+  expired.forEach(function (key) {
+    localStorage.removeItem(key);
+  });
+}
+
+function writeCache(cell, weather) {
+  pruneCache();
+  localStorage.setItem(CACHE_KEY_PREFIX + cell, JSON.stringify({
+    fetched: Date.now(),
+    weather: weather
+  }));
+}
+
+// fetches the forecast for a grid cell, sharing one XHR between
+// concurrent callers for the same cell, callbacks get null on failure
+function fetchForecast(cell, lat, lon, callback) {
+  if (pendingRequests[cell]) {
+    pendingRequests[cell].push(callback);
+    return;
+  }
+  pendingRequests[cell] = [callback];
+
+  var finish = function (weather) {
+    var callbacks = pendingRequests[cell];
+    delete pendingRequests[cell];
+    if (weather) {
+      writeCache(cell, weather);
+    }
+    callbacks.forEach(function (cb) {
+      cb(weather);
+    });
+  };
+
+  var weatherUrl = FORECAST_BASE_URL + myAPIKey + '/' + lat + ',' + lon;
+  xhrRequest(weatherUrl, 'GET',
+    function (responseText) {
+      // anything malformed still has to finish, or the cell stays pending
+      var weather = null;
+      try {
+        var json = JSON.parse(responseText);
+        if (!json.currently || typeof json.currently.temperature !== 'number') {
+          throw new Error("no current conditions");
+        }
+        weather = {
+          // round temperature
+          temperature: Math.round(json.currently.temperature),
+          icon: json.currently.icon,
+          // observation time, fall back to now if missing
+          time: json.currently.time || Math.floor(Date.now() / 1000),
+          hourly: extractHourly(json)
+        };
+      } catch (e) {
+        console.log("Error parsing forecast! " + e.message);
+      }
+      finish(weather);
+    },
+    function () {
+      console.log("Error requesting forecast!");
+      finish(null);
+    }
+  );
+}
+
+// keeps the upcoming hours of the forecast, starting at the current hour
+function extractHourly(json) {
+  if (!json.hourly || !json.hourly.data) {
+    return [];
+  }
+  var hourStart = Math.floor(Date.now() / 3600000) * 3600;
+  return json.hourly.data.filter(function (hour) {
+    return hour.time >= hourStart;
+  }).slice(0, FORECAST_HOURS).map(function (hour) {
+    return {time: hour.time, temperature: Math.round(hour.temperature), icon: hour.icon};
+  });
+}
+
+// assembles the weather dictionary using keys
+function weatherMessage(weather) {
+  var dictionary = {
+    "KEY_WEATHER": packWeather(weather.temperature, weather.icon, weather.time, WEATHER_FLAG_FAHRENHEIT)
+  };
+  // hours already past are dropped by the watch as it advances
+  if (weather.hourly && weather.hourly.length) {
+    dictionary.KEY_FORECAST = packForecast(weather.hourly, WEATHER_FLAG_FAHRENHEIT);
+  }
+  return dictionary;
+}
+
+function sendWeather(weather) {
+  console.log("Temperature is " + weather.temperature);
+  console.log("Current icon is " + weather.icon);
+
+  // Send to Pebble, replacing any older report still waiting
+  queueMessage('weather', weatherMessage(weather));
+}
+
+// packs weather into the byte layout the watch decodes
+function packWeather(temperature, icon, observed, flags) {
+  var condition = CONDITION_CODES.hasOwnProperty(icon) ? CONDITION_CODES[icon] : WEATHER_CONDITION_UNKNOWN;
+  return [
+    WEATHER_PROTOCOL_VERSION,
+    condition,
+    temperature & 0xFF, (temperature >> 8) & 0xFF,
+    observed & 0xFF, (observed >> 8) & 0xFF, (observed >> 16) & 0xFF, (observed >>> 24) & 0xFF,
+    flags & 0xFF
+  ];
+}
+
+// packs consecutive hours into the forecast layout, see src/protocol.h
+function packForecast(hours, flags) {
+  var start = hours[0].time;
+  var bytes = [
+    FORECAST_PROTOCOL_VERSION,
+    hours.length,
+    start & 0xFF, (start >> 8) & 0xFF, (start >> 16) & 0xFF, (start >>> 24) & 0xFF,
+    flags & 0xFF
+  ];
+  hours.forEach(function (hour) {
+    var temperature = Math.max(-128, Math.min(127, hour.temperature));
+    bytes.push(temperature & 0xFF,
+               CONDITION_CODES.hasOwnProperty(hour.icon) ? CONDITION_CODES[hour.icon] : WEATHER_CONDITION_UNKNOWN);
+  });
+  return bytes;
+}
+
 function locationSuccess(pos) {
   // to fake current lat/lon for testing
   // pos.coords.latitude = '29.5411941';
   // pos.coords.longitude = '-98.5760687';
 
-  // Construct URL
-  var weatherUrl = 'https://api.forecast.io/forecast/' + myAPIKey + '/' + pos.coords.latitude + ',' + pos.coords.longitude;
-  
-  // get forecast through dark sky
-  xhrRequest(weatherUrl, 'GET', 
-    function(responseText) {
-      var json = JSON.parse(responseText);
-      
-      // round temperature
-      var curTemp = Math.round(json.currently.temperature);
-      console.log("Temperature is " + curTemp);
-      
-      // icon for weather condition
-      var icon = json.currently.icon;
-      console.log("Current icon is " + icon);
-      
-      // assemble dictionary using keys
-      var dictionary = {
-        "KEY_TEMP": curTemp,
-        "KEY_ICON": icon,
-      };
-      
-      // Send to Pebble
-      Pebble.sendAppMessage(dictionary,
-        function(e) {
-          console.log("Weather info sent to Pebble successfully!");
-        },
-        function(e) {
-          console.log("Error sending weather info to Pebble!");
-        }
-      );
-    }      
-  );
+  var lat = quantize(pos.coords.latitude);
+  var lon = quantize(pos.coords.longitude);
+  var cell = lat + ',' + lon;
+
+  // a fresh cached forecast answers the watch without a fetch
+  var cached = readCache(cell);
+  if (cached && cached.weather && Date.now() - cached.fetched < CACHE_TTL_MS) {
+    sendWeather(cached.weather);
+    return;
+  }
+
+  // the watch gets the stale copy right away while dark sky refetches,
+  // a refetched report replaces it in the queue if still unsent
+  var stale = null;
+  if (cached && cached.weather && Date.now() - cached.fetched < CACHE_MAX_AGE_MS) {
+    stale = JSON.stringify(weatherMessage(cached.weather));
+    sendWeather(cached.weather);
+  }
+  fetchForecast(cell, lat, lon, function (weather) {
+    // an unchanged report is not worth a second message
+    if (weather && JSON.stringify(weatherMessage(weather)) !== stale) {
+      sendWeather(weather);
+    }
+  });
+}
+
+function readU32(bytes, offset) {
+  return (bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | (bytes[offset + 3] << 24)) >>> 0;
+}
+
+// logs the counters dumped by the watch, see src/profile.h, a dump
+// from any other version is dropped rather than misread
+function logProfile(bytes) {
+  if (bytes[0] !== PROFILE_DUMP_VERSION) {
+    console.log("Ignoring profile dump version " + bytes[0] + ", expected " + PROFILE_DUMP_VERSION);
+    return;
+  }
+  var count = bytes[1];
+  var events = 2 + count * 10 + 8;
+  var energy = events + 5 + bytes[events + 4] * 4;
+  var scheduler = energy + 1 + bytes[energy] * 4;
+  // offsets read past a short dump are NaN, so test for the full length
+  if (!(bytes.length >= scheduler + 23 + 16)) {
+    console.log("Ignoring truncated profile dump of " + bytes.length + " bytes");
+    return;
+  }
+  for (var i = 0; i < count; i++) {
+    var offset = 2 + i * 10;
+    var calls = readU32(bytes, offset);
+    var total = readU32(bytes, offset + 4);
+    var max = bytes[offset + 8] | (bytes[offset + 9] << 8);
+    console.log("profile " + (PROFILE_SLOT_NAMES[i] || i) + " calls=" + calls +
+                " total=" + total + "ms avg=" + (calls ? (total / calls).toFixed(1) : 0) + "ms max=" + max + "ms");
+  }
+  var heap = 2 + count * 10;
+  console.log("heap peak=" + readU32(bytes, heap) + " loaded=" + readU32(bytes, heap + 4));
+  var seconds = readU32(bytes, events);
+  // scale to a full day so runs of different length compare
+  var perDay = seconds ? 86400 / seconds : 0;
+  for (i = 0, offset = events + 5; offset < energy; i++, offset += 4) {
+    var n = readU32(bytes, offset);
+    console.log("event " + (PROFILE_EVENT_NAMES[i] || i) + " count=" + n + " perDay=" + Math.round(n * perDay));
+  }
+  var energyTotal = 0;
+  for (i = 0, offset = energy + 1; offset < scheduler; i++, offset += 4) {
+    var uj = readU32(bytes, offset);
+    energyTotal += uj;
+    console.log("energy " + (PROFILE_ENERGY_NAMES[i] || i) + "=" + uj + "uJ perDay=" + Math.round(uj * perDay) + "uJ");
+  }
+  console.log("energy total=" + energyTotal + "uJ over " + seconds + "s perDay=" + Math.round(energyTotal * perDay) + "uJ");
+  offset = scheduler;
+  console.log("scheduler requests=" + readU32(bytes, offset) + " acks=" + readU32(bytes, offset + 4) +
+              " failures=" + readU32(bytes, offset + 8) + " deliveries=" + readU32(bytes, offset + 12) +
+              " skipped=" + readU32(bytes, offset + 16) +
+              " interval=" + (bytes[offset + 20] | (bytes[offset + 21] << 8)) + "min backoff=" + bytes[offset + 22]);
+  offset += 23;
+  console.log("link raw=" + readU32(bytes, offset) + " absorbed=" + readU32(bytes, offset + 4) +
+              " transitions=" + readU32(bytes, offset + 8) + " alerts=" + readU32(bytes, offset + 12));
 }
 
 function locationError(err) {
@@ -66,8 +402,33 @@ Pebble.addEventListener('ready',
   function(e) {
     console.log("PebbleKit JS ready!");
 
-    // Get the initial weather
-    getWeather();
+    // tell the watch we're up, it asks for weather only if its copy is stale
+    var ready = { "KEY_JS_READY": 1 };
+    var stepGoal = parseInt(localStorage.getItem(STEP_GOAL_KEY), 10);
+    if (stepGoal > 0) {
+      ready.KEY_STEP_GOAL = stepGoal;
+    }
+    var quietStart = parseInt(localStorage.getItem(QUIET_START_KEY), 10);
+    var quietEnd = parseInt(localStorage.getItem(QUIET_END_KEY), 10);
+    if (quietStart >= 0 && quietEnd >= 0) {
+      ready.KEY_QUIET_START = quietStart;
+      ready.KEY_QUIET_END = quietEnd;
+    }
+    var disconnectGrace = parseInt(localStorage.getItem(DISCONNECT_GRACE_KEY), 10);
+    if (disconnectGrace > 0) {
+      ready.KEY_DISCONNECT_GRACE = disconnectGrace;
+    }
+    var refreshInterval = parseInt(localStorage.getItem(REFRESH_INTERVAL_KEY), 10);
+    if (refreshInterval > 0) {
+      ready.KEY_REFRESH_INTERVAL = refreshInterval;
+    }
+    if (localStorage.getItem(PROFILE_KEY) === '1') {
+      ready.KEY_PROFILE_REQUEST = 1;
+    }
+    queueMessage('ready', ready, function () {
+      // older watch build or not listening, fetch anyway
+      getWeather();
+    });
   }
 );
 
@@ -75,6 +436,11 @@ Pebble.addEventListener('ready',
 Pebble.addEventListener('appmessage',
   function(e) {
     console.log("AppMessage received!");
-    getWeather();
+    if (e.payload && e.payload.KEY_PROFILE) {
+      logProfile(e.payload.KEY_PROFILE);
+    }
+    if (e.payload && e.payload.KEY_REQUEST_WEATHER) {
+      getWeather();
+    }
   }                     
 );
@@ -0,0 +1,80 @@
+#include "link.h"
+#include "profile.h"
+
+static LinkHandler s_handler;
+static LinkStats s_stats;
+static AppTimer *s_timer;
+static uint32_t s_disconnect_grace = LINK_DISCONNECT_GRACE_MS;
+static bool s_raw;
+static bool s_settled;
+static time_t s_last_alert;
+
+static void link_cancel() {
+  if(s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+}
+
+//////////////////////////////////////////
+// raw state held for its grace period, //
+// make it the debounced state          //
+//////////////////////////////////////////
+static void link_settle(void *context) {
+  s_timer = NULL;
+  s_settled = s_raw;
+  s_stats.transitions++;
+  
+  bool alert = false;
+  if(!s_settled) {
+    time_t now = time(NULL);
+    // a reconnect storm alerts once, not once per drop
+    if(!s_last_alert || now - s_last_alert >= LINK_ALERT_MIN_GAP) {
+      s_last_alert = now;
+      s_stats.alerts++;
+      alert = true;
+    }
+  }
+  LOG_DEBUG("link %d raw=%d absorbed=%d alerts=%d", s_settled, (int)s_stats.raw_changes,
+            (int)s_stats.absorbed, (int)s_stats.alerts);
+  if(s_handler) {
+    s_handler(s_settled, alert);
+  }
+}
+
+void link_init(bool connected, LinkHandler handler) {
+  link_cancel();
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_handler = handler;
+  s_raw = s_settled = connected;
+  s_last_alert = 0;
+}
+
+void link_deinit() {
+  link_cancel();
+  s_handler = NULL;
+}
+
+void link_set_disconnect_grace(uint32_t grace_ms) {
+  s_disconnect_grace = grace_ms ? grace_ms : LINK_DISCONNECT_GRACE_MS;
+}
+
+void link_raw_update(bool connected) {
+  s_stats.raw_changes++;
+  if(connected == s_raw) {
+    return;
+  }
+  s_raw = connected;
+  
+  if(s_timer) {
+    // back where we settled before the grace ran out, nothing happened
+    link_cancel();
+    s_stats.absorbed++;
+    return;
+  }
+  s_timer = app_timer_register(connected ? LINK_RECONNECT_GRACE_MS : s_disconnect_grace, link_settle, NULL);
+}
+
+const LinkStats *link_get_stats() {
+  return &s_stats;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// debounced phone link state                    //
+// raw connection changes only take effect once  //
+// they have held for a grace period, so a       //
+// flapping link neither buzzes nor redraws      //
+///////////////////////////////////////////////////
+#define LINK_DISCONNECT_GRACE_MS 30000  // down this long before it counts
+#define LINK_RECONNECT_GRACE_MS 5000    // up this long before the link is usable
+#define LINK_ALERT_MIN_GAP 300          // seconds between two disconnect alerts
+
+// called when the debounced state changes, connected means the link
+// held for the reconnect grace and is usable, alert is set for the
+// first sustained disconnect after the minimum gap
+typedef void (*LinkHandler)(bool connected, bool alert);
+
+typedef struct {
+  uint32_t raw_changes;    // callbacks from the connection service
+  uint32_t absorbed;       // changes undone within their grace period
+  uint32_t transitions;    // debounced state changes
+  uint32_t alerts;
+} LinkStats;
+
+// takes the current state as settled, the handler is not called
+void link_init(bool connected, LinkHandler handler);
+void link_deinit();
+
+// disconnect grace in ms, 0 keeps the default
+void link_set_disconnect_grace(uint32_t grace_ms);
+
+// feed every raw connection service callback here
+void link_raw_update(bool connected);
+
+const LinkStats *link_get_stats();
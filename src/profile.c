@@ -0,0 +1,174 @@
+#include "profile.h"
+#include "scheduler.h"
+#include "link.h"
+
+#if PROFILE_ENABLED
+
+static ProfileCounter s_counters[PROFILE_SLOT_COUNT];
+static HeapStats s_heap;
+static uint32_t s_events[PROFILE_EVENT_COUNT];
+// first event counted, events are rated against the time since
+static time_t s_events_since;
+
+static const char *PROFILE_SLOT_NAMES[PROFILE_SLOT_COUNT] = {
+  "dial",
+  "hands",
+  "battery",
+  "health"
+};
+
+static const char *PROFILE_EVENT_NAMES[PROFILE_EVENT_COUNT] = {
+  "tick",
+  "health",
+  "worker",
+  "battery",
+  "bluetooth",
+  "tap",
+  "button",
+  "inbox",
+  "outbox",
+  "vibe"
+};
+
+static const char *PROFILE_ENERGY_NAMES[PROFILE_ENERGY_COUNT] = {
+  "render",
+  "wakeup",
+  "radio",
+  "vibe"
+};
+
+uint32_t profile_now_ms() {
+  time_t seconds;
+  uint16_t millis;
+  time_ms(&seconds, &millis);
+  return (uint32_t)seconds * 1000 + millis;
+}
+
+void profile_record(ProfileSlot slot, uint32_t start_ms) {
+  uint32_t elapsed = profile_now_ms() - start_ms;
+  ProfileCounter *counter = &s_counters[slot];
+  counter->calls++;
+  counter->total_ms += elapsed;
+  if(elapsed > counter->max_ms) {
+    counter->max_ms = elapsed > UINT16_MAX ? UINT16_MAX : elapsed;
+  }
+  
+  // lazily built bitmaps like the dial cache show up here
+  uint32_t used = heap_bytes_used();
+  if(used > s_heap.peak) {
+    s_heap.peak = used;
+  }
+}
+
+void profile_heap_mark(HeapPhase phase) {
+  uint32_t used = heap_bytes_used();
+  s_heap.used[phase] = used;
+  if(used > s_heap.peak) {
+    s_heap.peak = used;
+  }
+  
+  if(phase == HEAP_PHASE_AFTER_LOAD && used - s_heap.used[HEAP_PHASE_BEFORE_LOAD] > HEAP_BUDGET_BYTES) {
+    LOG_ERROR("heap over budget after load: %d bytes", (int)(used - s_heap.used[HEAP_PHASE_BEFORE_LOAD]));
+  }
+  LOG_DEBUG("heap phase %d used=%d peak=%d", phase, (int)used, (int)s_heap.peak);
+}
+
+void profile_count(ProfileEvent event) {
+  if(!s_events_since) {
+    s_events_since = time(NULL);
+  }
+  s_events[event]++;
+}
+
+uint32_t profile_energy(ProfileEnergy energy) {
+  uint32_t total = 0;
+  switch(energy) {
+    case PROFILE_ENERGY_RENDER:
+      for(int i=0; i<PROFILE_SLOT_COUNT; i++) {
+        total += s_counters[i].total_ms;
+      }
+      return total * ENERGY_UJ_PER_RENDER_MS;
+    case PROFILE_ENERGY_WAKEUP:
+      for(int i=PROFILE_EVENT_TICK; i<=PROFILE_EVENT_BUTTON; i++) {
+        total += s_events[i];
+      }
+      return total * ENERGY_UJ_PER_WAKEUP;
+    case PROFILE_ENERGY_RADIO:
+      return (s_events[PROFILE_EVENT_INBOX] + s_events[PROFILE_EVENT_OUTBOX]) * ENERGY_UJ_PER_MESSAGE;
+    case PROFILE_ENERGY_VIBE:
+      return s_events[PROFILE_EVENT_VIBE] * ENERGY_UJ_PER_VIBE;
+    default:
+      return 0;
+  }
+}
+
+const HeapStats *profile_heap_stats() {
+  return &s_heap;
+}
+
+const ProfileCounter *profile_get(ProfileSlot slot) {
+  return &s_counters[slot];
+}
+
+static uint8_t *write_u32(uint8_t *out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = (value >> 24) & 0xFF;
+  return out + 4;
+}
+
+size_t profile_serialize(uint8_t *buffer, size_t size) {
+  if(size < PROFILE_DUMP_SIZE) {
+    return 0;
+  }
+  uint8_t *out = buffer;
+  *out++ = PROFILE_DUMP_VERSION;
+  *out++ = PROFILE_SLOT_COUNT;
+  for(int i=0; i<PROFILE_SLOT_COUNT; i++) {
+    out = write_u32(out, s_counters[i].calls);
+    out = write_u32(out, s_counters[i].total_ms);
+    *out++ = s_counters[i].max_ms & 0xFF;
+    *out++ = (s_counters[i].max_ms >> 8) & 0xFF;
+  }
+  out = write_u32(out, s_heap.peak);
+  out = write_u32(out, s_heap.used[HEAP_PHASE_AFTER_LOAD]);
+  out = write_u32(out, s_events_since ? time(NULL) - s_events_since : 0);
+  *out++ = PROFILE_EVENT_COUNT;
+  for(int i=0; i<PROFILE_EVENT_COUNT; i++) {
+    out = write_u32(out, s_events[i]);
+  }
+  *out++ = PROFILE_ENERGY_COUNT;
+  for(int i=0; i<PROFILE_ENERGY_COUNT; i++) {
+    out = write_u32(out, profile_energy(i));
+  }
+  const SchedulerStats *scheduler = scheduler_get_stats();
+  out = write_u32(out, scheduler->requests);
+  out = write_u32(out, scheduler->acks);
+  out = write_u32(out, scheduler->failures);
+  out = write_u32(out, scheduler->deliveries);
+  out = write_u32(out, scheduler->skipped);
+  *out++ = scheduler->interval & 0xFF;
+  *out++ = (scheduler->interval >> 8) & 0xFF;
+  *out++ = scheduler->backoff_level;
+  const LinkStats *link = link_get_stats();
+  out = write_u32(out, link->raw_changes);
+  out = write_u32(out, link->absorbed);
+  out = write_u32(out, link->transitions);
+  out = write_u32(out, link->alerts);
+  return out - buffer;
+}
+
+void profile_log() {
+  for(int i=0; i<PROFILE_SLOT_COUNT; i++) {
+    LOG_DEBUG("profile %s calls=%d total=%dms max=%dms", PROFILE_SLOT_NAMES[i],
+              (int)s_counters[i].calls, (int)s_counters[i].total_ms, s_counters[i].max_ms);
+  }
+  for(int i=0; i<PROFILE_EVENT_COUNT; i++) {
+    LOG_DEBUG("event %s count=%d", PROFILE_EVENT_NAMES[i], (int)s_events[i]);
+  }
+  for(int i=0; i<PROFILE_ENERGY_COUNT; i++) {
+    LOG_DEBUG("energy %s %duJ", PROFILE_ENERGY_NAMES[i], (int)profile_energy(i));
+  }
+}
+#endif
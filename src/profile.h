@@ -0,0 +1,171 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// compile-time log levels                       //
+// messages above LOG_LEVEL compile to nothing,  //
+// release builds (-DRELEASE) log nothing        //
+///////////////////////////////////////////////////
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef LOG_LEVEL
+#ifdef RELEASE
+#define LOG_LEVEL LOG_LEVEL_NONE
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) APP_LOG(APP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) APP_LOG(APP_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) APP_LOG(APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while(0)
+#endif
+
+///////////////////////////////////////////////////
+// per update proc counters                      //
+// compiled out unless PROFILE_ENABLED is set,   //
+// on by default outside release builds          //
+///////////////////////////////////////////////////
+#ifndef PROFILE_ENABLED
+#ifdef RELEASE
+#define PROFILE_ENABLED 0
+#else
+#define PROFILE_ENABLED 1
+#endif
+#endif
+
+typedef enum {
+  PROFILE_DIAL,
+  PROFILE_HANDS,
+  PROFILE_BATTERY,
+  PROFILE_HEALTH,
+  PROFILE_SLOT_COUNT
+} ProfileSlot;
+
+typedef struct {
+  uint32_t calls;
+  uint32_t total_ms;
+  uint16_t max_ms;
+} ProfileCounter;
+
+///////////////////////////////////////////////////
+// events that wake the watch, counted per       //
+// handler to estimate what a day on the face    //
+// costs, see profile_energy                     //
+///////////////////////////////////////////////////
+typedef enum {
+  PROFILE_EVENT_TICK,
+  PROFILE_EVENT_HEALTH,
+  PROFILE_EVENT_WORKER,
+  PROFILE_EVENT_BATTERY,
+  PROFILE_EVENT_BLUETOOTH,
+  PROFILE_EVENT_TAP,
+  PROFILE_EVENT_BUTTON,      // everything above counts as a plain wakeup
+  PROFILE_EVENT_INBOX,
+  PROFILE_EVENT_OUTBOX,
+  PROFILE_EVENT_VIBE,
+  PROFILE_EVENT_COUNT
+} ProfileEvent;
+
+// energy estimate per subsystem
+typedef enum {
+  PROFILE_ENERGY_RENDER,    // update procs, by measured ms
+  PROFILE_ENERGY_WAKEUP,    // handler dispatch without drawing
+  PROFILE_ENERGY_RADIO,     // app messages in and out
+  PROFILE_ENERGY_VIBE,      // motor
+  PROFILE_ENERGY_COUNT
+} ProfileEnergy;
+
+// rough costs in microjoules, good for comparing builds against each
+// other, not for predicting battery life
+#define ENERGY_UJ_PER_RENDER_MS 15     // cpu awake, ~4mA at 3.7V
+#define ENERGY_UJ_PER_WAKEUP 30        // ~2ms of cpu per dispatched event
+#define ENERGY_UJ_PER_MESSAGE 750      // ~20ms of radio at ~10mA
+#define ENERGY_UJ_PER_VIBE 120000      // double pulse, ~400ms at ~80mA
+
+///////////////////////////////////////////////////
+// heap accounting per window lifecycle phase    //
+///////////////////////////////////////////////////
+typedef enum {
+  HEAP_PHASE_BEFORE_LOAD,
+  HEAP_PHASE_AFTER_LOAD,
+  HEAP_PHASE_COUNT
+} HeapPhase;
+
+// ceiling for everything the window allocates on top of the
+// pre-load heap, including the dial cache built on first frame
+#define HEAP_BUDGET_BYTES (16 * 1024)
+
+typedef struct {
+  uint32_t used[HEAP_PHASE_COUNT];  // heap used at the last mark of each phase
+  uint32_t peak;                    // highest heap use seen
+} HeapStats;
+
+///////////////////////////////////////////////////
+// dump payload sent to the phone, little endian //
+// [0] version, [1] slot count, then per slot:   //
+// calls u32, total_ms u32, max_ms u16           //
+// then heap peak u32, heap after load u32       //
+// then seconds counted u32, event count u8,     //
+// per event u32, energy count u8, per           //
+// subsystem microjoules u32                     //
+// then weather scheduler requests, acks,        //
+// failures, deliveries, skipped u32, interval   //
+// u16, backoff level u8                         //
+// then link raw changes, absorbed, transitions, //
+// alerts u32                                    //
+///////////////////////////////////////////////////
+#define PROFILE_DUMP_VERSION 6
+#define PROFILE_DUMP_SLOT_SIZE 10
+#define PROFILE_DUMP_HEAP_SIZE 8
+#define PROFILE_DUMP_EVENTS_SIZE (4 + 1 + PROFILE_EVENT_COUNT * 4 + 1 + PROFILE_ENERGY_COUNT * 4)
+#define PROFILE_DUMP_SCHEDULER_SIZE (5 * 4 + 2 + 1)
+#define PROFILE_DUMP_LINK_SIZE (4 * 4)
+#define PROFILE_DUMP_SIZE (2 + PROFILE_SLOT_COUNT * PROFILE_DUMP_SLOT_SIZE + PROFILE_DUMP_HEAP_SIZE + \
+                           PROFILE_DUMP_EVENTS_SIZE + PROFILE_DUMP_SCHEDULER_SIZE + PROFILE_DUMP_LINK_SIZE)
+
+#if PROFILE_ENABLED
+#define PROFILE_BEGIN(slot) uint32_t profile_start_##slot = profile_now_ms()
+#define PROFILE_END(slot) profile_record(slot, profile_start_##slot)
+#define PROFILE_HEAP(phase) profile_heap_mark(phase)
+#define PROFILE_EVENT(event) profile_count(event)
+#else
+#define PROFILE_BEGIN(slot) do {} while(0)
+#define PROFILE_END(slot) do {} while(0)
+#define PROFILE_HEAP(phase) do {} while(0)
+#define PROFILE_EVENT(event) do {} while(0)
+#endif
+
+uint32_t profile_now_ms();
+void profile_record(ProfileSlot slot, uint32_t start_ms);
+const ProfileCounter *profile_get(ProfileSlot slot);
+
+// records heap use for a phase, logs budget overruns, leaks are
+// checked by the host tests, see test/heap_test.c
+void profile_heap_mark(HeapPhase phase);
+const HeapStats *profile_heap_stats();
+
+void profile_count(ProfileEvent event);
+
+// estimated microjoules spent by a subsystem since launch
+uint32_t profile_energy(ProfileEnergy energy);
+
+// writes the dump payload, returns bytes written
+size_t profile_serialize(uint8_t *buffer, size_t size);
+void profile_log();
@@ -0,0 +1,12 @@
+#include "protocol.h"
+
+bool weather_decode(const uint8_t *data, uint16_t length, WeatherReport *report) {
+  if(!data || length != WEATHER_PAYLOAD_SIZE || data[0] != WEATHER_PROTOCOL_VERSION) {
+    return false;
+  }
+  report->condition = data[1];
+  report->temperature = (int16_t)(data[2] | (data[3] << 8));
+  report->observed = (time_t)((uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24));
+  report->flags = data[8];
+  return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// AppMessage keys                               //
+// must match messageKeys in package.json        //
+///////////////////////////////////////////////////
+#define KEY_WEATHER 2
+#define KEY_JS_READY 3
+#define KEY_REQUEST_WEATHER 4
+#define KEY_STEP_GOAL 5
+#define KEY_PROFILE_REQUEST 6
+#define KEY_PROFILE 7
+#define KEY_QUIET_START 8
+#define KEY_QUIET_END 9
+#define KEY_FORECAST 10
+#define KEY_DISCONNECT_GRACE 11
+#define KEY_REFRESH_INTERVAL 12
+
+///////////////////////////////////////////////////
+// compact weather payload, little endian        //
+// [0]    protocol version                       //
+// [1]    condition code (WeatherCondition)      //
+// [2..3] temperature, int16                     //
+// [4..7] observation time, unix seconds         //
+// [8]    flags                                  //
+///////////////////////////////////////////////////
+#define WEATHER_PROTOCOL_VERSION 1
+#define WEATHER_PAYLOAD_SIZE 9
+
+#define WEATHER_FLAG_FAHRENHEIT (1 << 0)
+
+///////////////////////////////////////////////////
+// hourly forecast payload, little endian        //
+// [0]    protocol version                       //
+// [1]    hour count                             //
+// [2..5] start of the first hour, unix seconds  //
+// [6]    flags, as for weather                  //
+// then per hour: temperature int8, condition    //
+///////////////////////////////////////////////////
+#define FORECAST_PROTOCOL_VERSION 1
+#define FORECAST_HEADER_SIZE 7
+#define FORECAST_HOUR_SIZE 2
+#define FORECAST_PAYLOAD_SIZE(hours) (FORECAST_HEADER_SIZE + (hours) * FORECAST_HOUR_SIZE)
+
+///////////////////////////////////////////////////
+// weather conditions, in sprite sheet order     //
+// codes are shared with the phone in app.js     //
+///////////////////////////////////////////////////
+typedef enum {
+  WEATHER_CLEAR_DAY,
+  WEATHER_CLEAR_NIGHT,
+  WEATHER_RAIN,
+  WEATHER_SNOW,
+  WEATHER_SLEET,
+  WEATHER_WIND,
+  WEATHER_FOG,
+  WEATHER_CLOUDY,
+  WEATHER_PARTLY_CLOUDY_DAY,
+  WEATHER_PARTLY_CLOUDY_NIGHT,
+  WEATHER_CONDITION_COUNT
+} WeatherCondition;
+#define WEATHER_CONDITION_UNKNOWN 0xFF
+
+typedef struct {
+  time_t observed;
+  int16_t temperature;
+  uint8_t condition;
+  uint8_t flags;
+} WeatherReport;
+
+// decodes a weather payload, returns false if malformed or wrong version
+bool weather_decode(const uint8_t *data, uint16_t length, WeatherReport *report);
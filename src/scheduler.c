@@ -0,0 +1,134 @@
+#include "scheduler.h"
+#include "profile.h"
+
+static SchedulerStats s_stats;
+static uint16_t s_base_interval = SCHEDULER_DEFAULT_INTERVAL;
+static uint8_t s_battery_factor = 1;
+
+//////////////////////////////////////////////
+// recomputes effective interval and moves  //
+// next due time when inputs change         //
+//////////////////////////////////////////////
+static void scheduler_update_interval() {
+  s_stats.interval = s_base_interval * s_battery_factor;
+  // one interval after the newer of the data and the last request, so
+  // a request still waiting for its reply is not due again right away
+  time_t since = MAX(s_stats.last_observed, s_stats.last_request);
+  if(since && !s_stats.backoff_level) {
+    s_stats.next_due = since + s_stats.interval * SECONDS_PER_MINUTE;
+  }
+}
+
+void scheduler_init(time_t last_observed) {
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_stats.connected = true;
+  s_stats.last_observed = last_observed;
+  scheduler_update_interval();
+}
+
+void scheduler_set_base_interval(uint16_t minutes) {
+  s_base_interval = minutes ? MIN(minutes, SCHEDULER_MAX_INTERVAL) : SCHEDULER_DEFAULT_INTERVAL;
+  scheduler_update_interval();
+}
+
+void scheduler_set_battery(uint8_t percent, bool charging) {
+  // stretch the interval as the battery drains
+  if(charging || percent > 50) {
+    s_battery_factor = 1;
+  } else if(percent > 20) {
+    s_battery_factor = 2;
+  } else {
+    s_battery_factor = 4;
+  }
+  scheduler_update_interval();
+}
+
+void scheduler_set_connected(bool connected) {
+  s_stats.connected = connected;
+}
+
+void scheduler_set_suspended(bool suspended) {
+  s_stats.suspended = suspended;
+}
+
+void scheduler_set_forecast(time_t until) {
+  s_stats.forecast_until = until;
+}
+
+bool scheduler_is_due(time_t now) {
+  if(s_stats.suspended) {
+    return false;
+  }
+  // the hourly forecast keeps the face current, only top it up before it runs out
+  if(now + SCHEDULER_FORECAST_MARGIN * SECONDS_PER_MINUTE < s_stats.forecast_until) {
+    return false;
+  }
+  // never two requests closer than the minimum gap, whatever the data age
+  if(s_stats.last_request && now < s_stats.last_request + SCHEDULER_MIN_GAP * SECONDS_PER_MINUTE) {
+    return false;
+  }
+  time_t due = s_stats.next_due;
+  // very old data drops the battery stretch, the base interval still applies
+  bool too_old = s_stats.last_observed && !s_stats.backoff_level &&
+                 now - s_stats.last_observed > SCHEDULER_MAX_AGE * SECONDS_PER_MINUTE;
+  if(too_old) {
+    due -= (s_stats.interval - s_base_interval) * SECONDS_PER_MINUTE;
+  }
+  if(now < due) {
+    return false;
+  }
+  if(!s_stats.connected) {
+    s_stats.skipped++;
+    return false;
+  }
+  return true;
+}
+
+void scheduler_request_sent(time_t now) {
+  s_stats.requests++;
+  s_stats.last_request = now;
+  s_stats.pending = true;
+  // wait at least one interval for the reply before asking again
+  s_stats.next_due = now + s_stats.interval * SECONDS_PER_MINUTE;
+}
+
+void scheduler_request_acked() {
+  s_stats.acks++;
+}
+
+void scheduler_request_failed(time_t now) {
+  s_stats.failures++;
+  s_stats.pending = false;
+  // exponential backoff, capped
+  uint32_t delay = SCHEDULER_BACKOFF_BASE << MIN(s_stats.backoff_level, 6);
+  if(delay > SCHEDULER_BACKOFF_MAX) {
+    delay = SCHEDULER_BACKOFF_MAX;
+  }
+  if(s_stats.backoff_level < UINT8_MAX) {
+    s_stats.backoff_level++;
+  }
+  s_stats.next_due = now + delay * SECONDS_PER_MINUTE;
+}
+
+void scheduler_weather_received(time_t observed, time_t now) {
+  s_stats.deliveries++;
+  s_stats.pending = false;
+  s_stats.backoff_level = 0;
+  s_stats.last_observed = observed;
+  scheduler_update_interval();
+  // a stale report from the phone's cache must not trigger a request storm
+  if(s_stats.next_due < now + SCHEDULER_MIN_GAP * SECONDS_PER_MINUTE) {
+    s_stats.next_due = now + SCHEDULER_MIN_GAP * SECONDS_PER_MINUTE;
+  }
+}
+
+const SchedulerStats *scheduler_get_stats() {
+  return &s_stats;
+}
+
+void scheduler_log_stats() {
+  LOG_DEBUG("scheduler req=%d ack=%d fail=%d recv=%d skip=%d interval=%d backoff=%d due=%d forecast=%d",
+          (int)s_stats.requests, (int)s_stats.acks, (int)s_stats.failures, (int)s_stats.deliveries,
+          (int)s_stats.skipped, s_stats.interval, s_stats.backoff_level, (int)s_stats.next_due,
+          (int)s_stats.forecast_until);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// weather refresh scheduler                     //
+// decides when the watch asks the phone for     //
+// weather, based on data age, battery level,    //
+// connection state and recent send failures     //
+///////////////////////////////////////////////////
+#define SCHEDULER_DEFAULT_INTERVAL 30   // minutes between refreshes
+#define SCHEDULER_MIN_GAP 5             // minutes between any two requests
+#define SCHEDULER_MAX_AGE 180           // minutes before battery stretching is ignored
+#define SCHEDULER_MAX_INTERVAL 720      // minutes, longest base interval the phone may set
+#define SCHEDULER_BACKOFF_BASE 1        // minutes after first failure
+#define SCHEDULER_BACKOFF_MAX 60        // minutes, backoff ceiling
+#define SCHEDULER_FORECAST_MARGIN 360   // minutes of forecast left before refreshing it
+
+typedef struct {
+  uint32_t requests;       // requests handed to the outbox
+  uint32_t acks;           // requests acknowledged by the phone
+  uint32_t failures;       // requests that failed to send
+  uint32_t deliveries;     // weather reports received
+  uint32_t skipped;        // due while disconnected
+  time_t last_observed;    // observation time of current data
+  time_t last_request;     // last request handed to the outbox
+  time_t next_due;         // next time a request is allowed
+  time_t forecast_until;   // end of the hourly forecast held on the watch
+  uint16_t interval;       // current effective interval, minutes
+  uint8_t backoff_level;   // consecutive failures
+  bool connected;
+  bool suspended;          // low power, no requests at all
+  bool pending;            // a request is waiting for its report
+} SchedulerStats;
+
+void scheduler_init(time_t last_observed);
+// base minutes between refreshes, 0 restores the default
+void scheduler_set_base_interval(uint16_t minutes);
+void scheduler_set_battery(uint8_t percent, bool charging);
+void scheduler_set_connected(bool connected);
+void scheduler_set_suspended(bool suspended);
+void scheduler_set_forecast(time_t until);
+
+// true if a request should be sent now
+bool scheduler_is_due(time_t now);
+
+void scheduler_request_sent(time_t now);
+void scheduler_request_acked();
+void scheduler_request_failed(time_t now);
+void scheduler_weather_received(time_t observed, time_t now);
+
+const SchedulerStats *scheduler_get_stats();
+void scheduler_log_stats();
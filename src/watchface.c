@@ -1,74 +1,160 @@
 #include <pebble.h>
-#define KEY_TEMP 0
-#define KEY_ICON 1
+#include "geometry.h"
+#include "gauge.h"
+#include "protocol.h"
+#include "scheduler.h"
+#include "forecast.h"
+#include "histogram.h"
+#include "digits.h"
+#include "link.h"
+#include "profile.h"
 
 static Window *s_main_window;
 static Layer *s_dial_layer, *s_hands_layer, *s_temp_circle, *s_battery_circle, *s_health_circle;
-static TextLayer *s_temp_layer, *s_health_layer, *s_day_text_layer, *s_date_text_layer;
-static GBitmap *s_weather_bitmap, *s_health_bitmap, *s_bluetooth_bitmap, *s_charging_bitmap, *s_bluetooth_bitmap;
-static BitmapLayer *s_weather_bitmap_layer, *s_health_bitmap_layer, *s_bluetooth_bitmap_layer, *s_charging_bitmap_layer, *s_bluetooth_bitmap_layer;
-static GPath *s_minute_arrow, *s_hour_arrow, *s_minute_filler, *s_hour_filler;
-static int buf=8, battery_percent, step_goal=100;
+static Layer *s_temp_layer, *s_health_layer, *s_date_text_layer;
+static TextLayer *s_day_text_layer;
+static GBitmap *s_weather_atlas, *s_health_bitmap, *s_bluetooth_bitmap, *s_charging_bitmap;
+static BitmapLayer *s_weather_bitmap_layer, *s_health_bitmap_layer, *s_bluetooth_bitmap_layer, *s_charging_bitmap_layer;
+static GBitmap *s_dial_cache;
+static bool s_dial_cache_valid;
+static int buf=8;
 static GFont s_font;
-static char icon_layer_buf[32];
-static double step_count;
-static char *char_current_steps;
-static bool charging;
 
-//////////////////////
-// draw minute hand //
-//////////////////////
-static const GPathInfo MINUTE_HAND_POINTS = {
-  5, (GPoint []) {
-    {5, 16},
-    {-5, 16},
-    {-4, -64},
-    {0, -70},
-    {4, -64}
-  }
+// movement events are batched for this long before steps are re-read
+#define HEALTH_COALESCE_MS 30000
+// goal used until the phone sends one
+#define DEFAULT_STEP_GOAL 100
+static int32_t step_goal=DEFAULT_STEP_GOAL;
+static AppTimer *s_health_timer;
+
+// hourly step bars, their points come from STEP_BAR_TABLE
+#define HISTOGRAM_MAX_LENGTH STEP_BAR_MAX_LENGTH
+// bars scale to the busiest hour, but never below this many steps
+#define HISTOGRAM_MIN_SCALE 500
+static Layer *s_histogram_layer;
+static uint8_t s_histogram_lengths[HISTOGRAM_HOURS];
+
+// background worker aggregating steps, see worker_src/worker.c
+// without it the face reads health itself
+static bool s_worker_running;
+
+// a wrist flick shows the seconds hand for this long, building with
+// SECONDS_HAND_ENABLED=0 leaves out the hand, its timer and the tap
+// subscription
+#ifndef SECONDS_HAND_ENABLED
+#define SECONDS_HAND_ENABLED 1
+#endif
+#if SECONDS_HAND_ENABLED
+#define SECONDS_HAND_DURATION_MS 10000
+static AppTimer *s_seconds_timer;
+#endif
+
+// quiet hours drop to low power even when awake, start == end disables
+// the window, the phone can override both with the ready message
+#define DEFAULT_QUIET_START_HOUR 0
+#define DEFAULT_QUIET_END_HOUR 0
+static int8_t s_quiet_start = DEFAULT_QUIET_START_HOUR;
+static int8_t s_quiet_end = DEFAULT_QUIET_END_HOUR;
+
+// each weather icon is a 16x16 cell in the atlas
+#define WEATHER_ICON_SIZE 16
+static GBitmap *s_weather_icons[WEATHER_CONDITION_COUNT];
+
+/////////////////////////////////////////////////////
+// everything shown on the face                    //
+// handlers diff new values against this and only  //
+// touch layers whose values actually changed      //
+/////////////////////////////////////////////////////
+typedef struct {
+  int8_t hour;               // hands
+  int8_t minute;
+  int8_t second;             // seconds hand, only while shown
+  bool seconds_shown;
+  int8_t mday;               // day and date box
+  int8_t wday;
+  int8_t battery_percent;    // battery gauge
+  bool charging;             // charging icon
+  HealthValue step_count;    // health gauge and text
+  WeatherReport weather;     // temp text and weather icon
+  bool connected;            // bluetooth icon
+  bool low_power;            // asleep or quiet hours, hands only
+} FaceState;
+
+// -1 marks values not seen yet, so the first update always applies
+static FaceState s_face = {
+  .hour = -1,
+  .minute = -1,
+  .second = -1,
+  .mday = -1,
+  .wday = -1,
+  .battery_percent = -1,
+  .weather = { .condition = WEATHER_CONDITION_UNKNOWN },
+  .connected = true
 };
-static const GPathInfo MINUTE_HAND_FILLER = {
-  4, (GPoint []) {
-    {2, -16},
-    {-2, -16},
-    {-2, -60},
-    {2, -60}
+
+// last known state, restored at launch so the first frame is populated
+#define PERSIST_KEY_STATE 1
+#define PERSIST_STATE_VERSION 1
+
+typedef struct {
+  uint8_t version;
+  WeatherReport weather;
+  HealthValue step_count;
+  int32_t step_goal;
+  time_t saved;
+} PersistedState;
+
+static void update_power_mode();
+#if PROFILE_ENABLED
+static void send_profile();
+#endif
+
+//////////////////////////////////////////////
+// NULL safe layer helpers, any create in   //
+// main_window_load may fail on a full heap //
+//////////////////////////////////////////////
+static void mark_dirty(Layer *layer) {
+  if(layer) {
+    layer_mark_dirty(layer);
   }
-};
+}
 
-////////////////////
-// draw hour hand //
-////////////////////
-static const GPathInfo HOUR_HAND_POINTS = {
-  5, (GPoint []) {
-    {5, 16},
-    {-5, 16},
-    {-4, -48}, 
-    {0, -54},
-    {4, -48}
+static void set_hidden(Layer *layer, bool hidden) {
+  if(layer) {
+    layer_set_hidden(layer, hidden);
   }
-};
-static const GPathInfo HOUR_HAND_FILLER = {
-  4, (GPoint []) {
-    {2, -16},
-    {-2, -16},
-    {-2, -44},
-    {2, -44}
+}
+
+static void set_icon_hidden(BitmapLayer *layer, bool hidden) {
+  if(layer) {
+    layer_set_hidden(bitmap_layer_get_layer(layer), hidden);
   }
-};
+}
+
+static void set_text(TextLayer *layer, const char *text) {
+  if(layer) {
+    text_layer_set_text(layer, text);
+  }
+}
+
+static void set_number(Layer *layer, int32_t value, uint8_t min_digits) {
+  if(layer) {
+    digits_layer_set_value(layer, value, min_digits);
+  }
+}
 
 //////////////////////
 // hide clock hands //
 //////////////////////
 static void hide_hands() {
-  layer_set_hidden(s_hands_layer, true); 
+  set_hidden(s_hands_layer, true); 
 }
 
 //////////////////////
 // show clock hands //
 //////////////////////
 static void show_hands() {
-  layer_set_hidden(s_hands_layer, false);
+  set_hidden(s_hands_layer, false);
 }
 
 /////////////////////////////////////////////////
@@ -76,60 +162,57 @@ static void show_hands() {
 // hides hands for 5 seconds, then shows again //
 /////////////////////////////////////////////////
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+  PROFILE_EVENT(PROFILE_EVENT_BUTTON);
   hide_hands();
   app_timer_register(5000, show_hands, NULL);
 }
 
+#if PROFILE_ENABLED
+//////////////////////////////////////////////
+// long select dumps the profile counters,  //
+// e.g. after a full day on the wrist       //
+//////////////////////////////////////////////
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  send_profile();
+}
+#endif
+
 ///////////////////
 // assign clicks //
 ///////////////////
 static void click_config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+#if PROFILE_ENABLED
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
+#endif
 }
 
-/////////////////////////
-// draws dial on watch //
-/////////////////////////
-static void dial_update_proc(Layer *layer, GContext *ctx) {
-  GRect bounds = layer_get_bounds(layer);
+//////////////////////////////////////////
+// draws static dial, ticks and date box //
+//////////////////////////////////////////
+static void draw_dial(GContext *ctx, GRect bounds) {
   GPoint center = grect_center_point(&bounds); 
   
   graphics_context_set_fill_color(ctx, GColorWhite);
   graphics_fill_circle(ctx, center, (bounds.size.w+buf)/2);
   
-  // set number of tickmarks
-  int tick_marks_number = 60;
-
-  // tick mark lengths
-  int tick_length_end = (bounds.size.w+buf)/2; 
-  int tick_length_start;
-  
   // set colors
   graphics_context_set_antialiased(ctx, true);
   graphics_context_set_fill_color(ctx, GColorWhite);
   graphics_context_set_stroke_color(ctx, GColorBlack);
-  graphics_context_set_stroke_width(ctx, 6);
   
-  for(int i=0; i<tick_marks_number; i++) {
+  for(int i=0; i<TICK_POSITIONS; i++) {
     // if number is divisible by 5, make large mark
-    if(i%5==0) {
-      graphics_context_set_stroke_width(ctx, 4);
-      tick_length_start = tick_length_end-8;
-    } else {
-      graphics_context_set_stroke_width(ctx, 1);
-      tick_length_start = tick_length_end-4;
-    }
-
-    int angle = TRIG_MAX_ANGLE * i/tick_marks_number;
-
+    graphics_context_set_stroke_width(ctx, i%5==0 ? 4 : 1);
+    
     GPoint tick_mark_start = {
-      .x = (int)(sin_lookup(angle) * (int)tick_length_start / TRIG_MAX_RATIO) + center.x,
-      .y = (int)(-cos_lookup(angle) * (int)tick_length_start / TRIG_MAX_RATIO) + center.y,
+      .x = TICK_TABLE[i][0].x + center.x,
+      .y = TICK_TABLE[i][0].y + center.y,
     };
     
     GPoint tick_mark_end = {
-      .x = (int)(sin_lookup(angle) * (int)tick_length_end / TRIG_MAX_RATIO) + center.x,
-      .y = (int)(-cos_lookup(angle) * (int)tick_length_end / TRIG_MAX_RATIO) + center.y,
+      .x = TICK_TABLE[i][1].x + center.x,
+      .y = TICK_TABLE[i][1].y + center.y,
     };      
     
     graphics_draw_line(ctx, tick_mark_end, tick_mark_start);  
@@ -142,6 +225,76 @@ static void dial_update_proc(Layer *layer, GContext *ctx) {
   GPoint start_temp_line = GPoint(114, 77);
   GPoint end_temp_line = GPoint(114, 88);
   graphics_draw_line(ctx, start_temp_line, end_temp_line);    
+  
+  // vertical battery outline and terminal, only the level is redrawn
+  graphics_context_set_stroke_width(ctx, 1);
+  graphics_draw_round_rect(ctx, GRect(31, 77, 7, 14), 1);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, GRect(33, 76, 3, 1), 0, GCornerNone);
+}
+
+/////////////////////////////////////////////////
+// forces the dial to be re-rendered on the    //
+// next frame, call when geometry/theme change //
+/////////////////////////////////////////////////
+static void dial_cache_invalidate() {
+  s_dial_cache_valid = false;
+  mark_dirty(s_dial_layer);
+}
+
+///////////////////////////////////////////////
+// copies freshly drawn dial out of the      //
+// frame buffer into the offscreen bitmap    //
+///////////////////////////////////////////////
+static void dial_cache_capture(GContext *ctx, GRect bounds) {
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if(!frame_buffer) {
+    return;
+  }
+  
+  // rebuild bitmap if layer size no longer matches
+  if(s_dial_cache) {
+    GRect cache_bounds = gbitmap_get_bounds(s_dial_cache);
+    if(!gsize_equal(&cache_bounds.size, &bounds.size)) {
+      gbitmap_destroy(s_dial_cache);
+      s_dial_cache = NULL;
+    }
+  }
+  if(!s_dial_cache) {
+    s_dial_cache = gbitmap_create_blank(bounds.size, gbitmap_get_format(frame_buffer));
+  }
+  
+  if(s_dial_cache) {
+    uint8_t *src = gbitmap_get_data(frame_buffer);
+    uint8_t *dst = gbitmap_get_data(s_dial_cache);
+    uint16_t src_row = gbitmap_get_bytes_per_row(frame_buffer);
+    uint16_t dst_row = gbitmap_get_bytes_per_row(s_dial_cache);
+    uint16_t row_bytes = MIN(src_row, dst_row);
+    for(int y=0; y<bounds.size.h; y++) {
+      memcpy(dst + y*dst_row, src + (bounds.origin.y+y)*src_row, row_bytes);
+    }
+    s_dial_cache_valid = true;
+  }
+  
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+////////////////////////////////////////////////
+// draws dial on watch                        //
+// renders once, then blits the cached bitmap //
+////////////////////////////////////////////////
+static void dial_update_proc(Layer *layer, GContext *ctx) {
+  PROFILE_BEGIN(PROFILE_DIAL);
+  GRect bounds = layer_get_bounds(layer);
+  
+  if(s_dial_cache_valid && s_dial_cache) {
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    graphics_draw_bitmap_in_rect(ctx, s_dial_cache, bounds);
+  } else {
+    draw_dial(ctx, bounds);
+    dial_cache_capture(ctx, bounds);
+  }
+  PROFILE_END(PROFILE_DIAL);
 }
 
 ////////////////////////
@@ -158,38 +311,73 @@ static void temp_update_proc(Layer *layer, GContext *ctx) {
 // update battery status //
 ///////////////////////////
 static void battery_update_proc(Layer *layer, GContext *ctx) {
-  GRect bounds = GRect(16, 66, 36, 36);
+  PROFILE_BEGIN(PROFILE_BATTERY);
+  GRect bounds = GRect(16, 66, GAUGE_DIAMETER, GAUGE_DIAMETER);
   graphics_context_set_fill_color(ctx, GColorBlack);
-  graphics_fill_radial(ctx, bounds, GOvalScaleModeFitCircle, 2, DEG_TO_TRIGANGLE(360-(battery_percent*3.6)), DEG_TO_TRIGANGLE(360));
+  gauge_fill(ctx, bounds, TRIG_MAX_ANGLE - gauge_angle_ceil(s_face.battery_percent, 100), TRIG_MAX_ANGLE);
   
-  // draw vertical battery
-  graphics_draw_round_rect(ctx, GRect(31, 77, 7, 14), 1);
-  int batt = battery_percent/10;
+  // battery level, the outline is part of the cached dial
+  int batt = s_face.battery_percent/10;
   graphics_fill_rect(ctx, GRect(33, 89-batt, 3, batt), 1, GCornerNone);
-  graphics_fill_rect(ctx, GRect(33, 76, 3, 1), 0, GCornerNone);  
-  
-  // set visibility of charging icon
-  layer_set_hidden(bitmap_layer_get_layer(s_charging_bitmap_layer), !charging);
+  PROFILE_END(PROFILE_BATTERY);
 }
 
 //////////////////////////
 // update health status //
 //////////////////////////
 static void health_update_proc(Layer *layer, GContext *ctx) {
-  GRect bounds = GRect(54, 104, 36, 36);
+  PROFILE_BEGIN(PROFILE_HEALTH);
+  GRect bounds = GRect(54, 104, GAUGE_DIAMETER, GAUGE_DIAMETER);
   graphics_context_set_fill_color(ctx, GColorBlack);
-  graphics_fill_radial(ctx, bounds, GOvalScaleModeFitCircle, 2, DEG_TO_TRIGANGLE(0), DEG_TO_TRIGANGLE((step_count/step_goal)*360));
+  gauge_fill(ctx, bounds, 0, gauge_angle_floor(s_face.step_count, step_goal));
+  PROFILE_END(PROFILE_HEALTH);
+}
+
+//////////////////////////////////////////
+// draws one step bar per clock hour    //
+//////////////////////////////////////////
+static void histogram_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  GPoint center = grect_center_point(&bounds);
+  graphics_context_set_stroke_color(ctx, GColorBlack);
+  graphics_context_set_stroke_width(ctx, 3);
+  for(int i=0; i<HISTOGRAM_HOURS; i++) {
+    if(!s_histogram_lengths[i]) {
+      continue;
+    }
+    const GPoint *bar = STEP_BAR_TABLE[i];
+    graphics_draw_line(ctx,
+      GPoint(bar[0].x + center.x, bar[0].y + center.y),
+      GPoint(bar[s_histogram_lengths[i]].x + center.x, bar[s_histogram_lengths[i]].y + center.y));
+  }
+}
+
+////////////////////////////////////////
+// draws a pre-rotated hand from the  //
+// generated tables, no trig involved //
+////////////////////////////////////////
+static void draw_hand(GContext *ctx, const GPoint *points, uint32_t num_points, GPoint center) {
+  GPath path = {
+    .num_points = num_points,
+    .points = (GPoint *)points,
+    .rotation = 0,
+    .offset = center
+  };
+  gpath_draw_filled(ctx, &path);
+  gpath_draw_outline(ctx, &path);
 }
 
 /////////////////////////////////
 // draw hands and update ticks //
 /////////////////////////////////
 static void ticks_update_proc(Layer *layer, GContext *ctx) {
+  PROFILE_BEGIN(PROFILE_HANDS);
   GRect bounds = layer_get_bounds(layer);
   GPoint center = grect_center_point(&bounds); 
-    
-  time_t now = time(NULL);
-  struct tm *t = localtime(&now);
+  
+  // hands follow the last applied time, no clock reads while drawing
+  int minute_index = s_face.minute;
+  int hour_index = ((s_face.hour % 12) * 6) + (s_face.minute / 10);
   
   // set stroke to 1
   graphics_context_set_stroke_width(ctx, 1);
@@ -198,28 +386,29 @@ static void ticks_update_proc(Layer *layer, GContext *ctx) {
   graphics_context_set_stroke_color(ctx, GColorBlack);
   
   // draw minute hand
-  gpath_rotate_to(s_minute_arrow, TRIG_MAX_ANGLE * t->tm_min / 60);
-  gpath_draw_filled(ctx, s_minute_arrow);
-  gpath_draw_outline(ctx, s_minute_arrow);
+  draw_hand(ctx, MINUTE_HAND_TABLE[minute_index], HAND_POINTS, center);
 
   // draw hour hand
-  gpath_rotate_to(s_hour_arrow, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
-  gpath_draw_filled(ctx, s_hour_arrow);
-  gpath_draw_outline(ctx, s_hour_arrow);
+  draw_hand(ctx, HOUR_HAND_TABLE[hour_index], HAND_POINTS, center);
   
   // switch color for fillers
   graphics_context_set_fill_color(ctx, GColorBlack);
   graphics_context_set_stroke_color(ctx, GColorBlack);  
    
   // draw minute filler
-  gpath_rotate_to(s_minute_filler, TRIG_MAX_ANGLE * t->tm_min / 60);
-  gpath_draw_filled(ctx, s_minute_filler);
-  gpath_draw_outline(ctx, s_minute_filler);
+  draw_hand(ctx, MINUTE_FILLER_TABLE[minute_index], FILLER_POINTS, center);
   
   // draw hour filler
-  gpath_rotate_to(s_hour_filler, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
-  gpath_draw_filled(ctx, s_hour_filler);
-  gpath_draw_outline(ctx, s_hour_filler);
+  draw_hand(ctx, HOUR_FILLER_TABLE[hour_index], FILLER_POINTS, center);
+  
+#if SECONDS_HAND_ENABLED
+  // draw seconds hand while a wrist flick keeps it up
+  if(s_face.seconds_shown && s_face.second >= 0) {
+    graphics_draw_line(ctx,
+      GPoint(SECOND_HAND_TABLE[s_face.second][0].x + center.x, SECOND_HAND_TABLE[s_face.second][0].y + center.y),
+      GPoint(SECOND_HAND_TABLE[s_face.second][1].x + center.x, SECOND_HAND_TABLE[s_face.second][1].y + center.y));
+  }
+#endif
 
   // switch colors for center circle
   graphics_context_set_fill_color(ctx, GColorWhite);
@@ -233,12 +422,219 @@ static void ticks_update_proc(Layer *layer, GContext *ctx) {
   // dot in the middle
   graphics_context_set_fill_color(ctx, GColorBlack);
   graphics_fill_circle(ctx, center, 1);
+  PROFILE_END(PROFILE_HANDS);
+}
+
+//////////////////////////////////////
+// display appropriate weather icon //
+//////////////////////////////////////
+static void load_icons() {
+  // condition code indexes straight into the sprite table
+  if(!s_weather_bitmap_layer) {
+    return;
+  }
+  bool known = s_face.weather.condition < WEATHER_CONDITION_COUNT && s_weather_icons[s_face.weather.condition];
+  if(known) {
+    bitmap_layer_set_bitmap(s_weather_bitmap_layer, s_weather_icons[s_face.weather.condition]);
+  }
+  set_icon_hidden(s_weather_bitmap_layer, !known);
+}
+
+///////////////////////////
+// display current temp  //
+///////////////////////////
+static void load_temp() {
+  set_number(s_temp_layer, s_face.weather.temperature, 0);
+}
+
+///////////////////////////////
+// display day and date text //
+///////////////////////////////
+static void load_date() {
+  // rebuild a tm from the applied state for strftime
+  struct tm date = { .tm_mday = s_face.mday, .tm_wday = s_face.wday };
+  
+  // write day to buffer
+  static char day_buffer[16];
+  strftime(day_buffer, sizeof(day_buffer), "%a", &date);
+  
+  // date goes through the glyph atlas, only the day name needs text
+  set_number(s_date_text_layer, s_face.mday, 2);
+  set_text(s_day_text_layer, day_buffer);  
+}
+
+////////////////////////////
+// display today's steps  //
+////////////////////////////
+static void load_steps() {
+  set_number(s_health_layer, s_face.step_count, 0);
+}
+
+/////////////////////////////////////
+// saves last known state to flash //
+/////////////////////////////////////
+static void state_save() {
+  PersistedState state = {
+    .version = PERSIST_STATE_VERSION,
+    .weather = s_face.weather,
+    .step_count = s_face.step_count,
+    .step_goal = step_goal,
+    .saved = time(NULL)
+  };
+  persist_write_data(PERSIST_KEY_STATE, &state, sizeof(state));
+}
+
+////////////////////////////////////////
+// restores last known state, steps   //
+// are only kept if saved today       //
+////////////////////////////////////////
+static void state_restore() {
+  PersistedState state;
+  if(!persist_exists(PERSIST_KEY_STATE) ||
+     persist_read_data(PERSIST_KEY_STATE, &state, sizeof(state)) != (int)sizeof(state) ||
+     state.version != PERSIST_STATE_VERSION) {
+    return;
+  }
+  s_face.weather = state.weather;
+  if(state.step_goal > 0) {
+    step_goal = state.step_goal;
+  }
+  if(state.saved >= time_start_of_today()) {
+    s_face.step_count = state.step_count;
+  }
+}
+
+////////////////////////////////////////
+// asks the phone for fresh weather   //
+////////////////////////////////////////
+static void request_weather() {
+  time_t now = time(NULL);
+  DictionaryIterator *iterator;
+  if(app_message_outbox_begin(&iterator) != APP_MSG_OK) {
+    scheduler_request_failed(now);
+    return;
+  }
+  dict_write_uint8(iterator, KEY_REQUEST_WEATHER, 1);
+  if(app_message_outbox_send() != APP_MSG_OK) {
+    scheduler_request_failed(now);
+    return;
+  }
+  scheduler_request_sent(now);
+  scheduler_log_stats();
+}
+
+#if PROFILE_ENABLED
+// dump waiting for the outbox, and whether the message in flight is it
+static bool s_profile_pending;
+static bool s_profile_in_flight;
+
+////////////////////////////////////////////
+// sends update proc counters to the      //
+// phone, or queues them behind the       //
+// message in flight                      //
+////////////////////////////////////////////
+static void send_profile() {
+  s_profile_pending = true;
+  DictionaryIterator *iterator;
+  if(app_message_outbox_begin(&iterator) != APP_MSG_OK) {
+    // the outbox callbacks send it once the outbox is free
+    LOG_DEBUG("profile dump queued behind outbox");
+    return;
+  }
+  s_profile_pending = false;
+  uint8_t payload[PROFILE_DUMP_SIZE];
+  size_t length = profile_serialize(payload, sizeof(payload));
+  dict_write_data(iterator, KEY_PROFILE, payload, length);
+  if(app_message_outbox_send() != APP_MSG_OK) {
+    LOG_ERROR("profile dump send failed");
+    return;
+  }
+  s_profile_in_flight = true;
+  profile_log();
+}
+
+//////////////////////////////////////////////
+// outbox finished a message, true if it    //
+// was the dump, then sends a queued dump   //
+//////////////////////////////////////////////
+static bool profile_outbox_done() {
+  bool was_dump = s_profile_in_flight;
+  s_profile_in_flight = false;
+  if(s_profile_pending) {
+    send_profile();
+  }
+  return was_dump;
+}
+#endif
+
+//////////////////////////////////////////
+// sends a weather request if the       //
+// scheduler says one is due            //
+//////////////////////////////////////////
+static void refresh_weather_if_due() {
+  if(scheduler_is_due(time(NULL))) {
+    request_weather();
+  }
+}
+
+////////////////////////////////////////////
+// creates a full size canvas layer under //
+// parent, NULL if out of memory          //
+////////////////////////////////////////////
+static Layer *create_canvas_layer(Layer *parent, GRect frame, LayerUpdateProc update_proc) {
+  Layer *layer = layer_create(frame);
+  if(layer) {
+    layer_set_update_proc(layer, update_proc);
+    layer_add_child(parent, layer);
+  }
+  return layer;
+}
+
+/////////////////////////////////////////////
+// creates a centered gothic 14 text layer //
+/////////////////////////////////////////////
+static TextLayer *create_text_layer(Layer *parent, GRect frame) {
+  TextLayer *layer = text_layer_create(frame);
+  if(layer) {
+    text_layer_set_background_color(layer, GColorClear);
+    text_layer_set_text_alignment(layer, GTextAlignmentCenter);
+    text_layer_set_font(layer, s_font);
+    layer_add_child(parent, text_layer_get_layer(layer));
+  }
+  return layer;
+}
+
+/////////////////////////////////////////////
+// creates a glyph atlas number layer      //
+// under parent, blank until set           //
+/////////////////////////////////////////////
+static Layer *create_number_layer(Layer *parent, GRect frame) {
+  Layer *layer = digits_layer_create(frame);
+  if(layer) {
+    layer_add_child(parent, layer);
+  }
+  return layer;
+}
+
+/////////////////////////////////////////////
+// creates a transparent icon layer, the   //
+// bitmap may be NULL and set later        //
+/////////////////////////////////////////////
+static BitmapLayer *create_icon_layer(Layer *parent, GRect frame, GBitmap *bitmap) {
+  BitmapLayer *layer = bitmap_layer_create(frame);
+  if(layer) {
+    bitmap_layer_set_compositing_mode(layer, GCompOpSet);
+    bitmap_layer_set_bitmap(layer, bitmap);
+    layer_add_child(parent, bitmap_layer_get_layer(layer));
+  }
+  return layer;
 }
 
 //////////////////////
 // load main window //
 //////////////////////
 static void main_window_load(Window *window) {
+  PROFILE_HEAP(HEAP_PHASE_BEFORE_LOAD);
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
   
@@ -250,250 +646,600 @@ static void main_window_load(Window *window) {
   
   s_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
 
-  // create canvas layer for dial
-  s_dial_layer = layer_create(bounds);
-  layer_set_update_proc(s_dial_layer, dial_update_proc);
-  layer_add_child(window_layer, s_dial_layer);  
+  // create canvas layer for dial, everything else hangs off it
+  s_dial_layer = create_canvas_layer(window_layer, bounds, dial_update_proc);
+  if(!s_dial_layer) {
+    LOG_ERROR("out of memory creating dial");
+    return;
+  }
+  // dial is rasterized on first frame and cached from then on
+  dial_cache_invalidate();
+  
+  // hourly step bars change too often to live in the cache
+  s_histogram_layer = create_canvas_layer(s_dial_layer, bounds, histogram_update_proc);
   
   // create temp circle
-  s_temp_circle = layer_create(bounds);
-  layer_set_update_proc(s_temp_circle, temp_update_proc);
-  layer_add_child(s_dial_layer, s_temp_circle);
+  s_temp_circle = create_canvas_layer(s_dial_layer, bounds, temp_update_proc);
+  
+  // slice weather sprite sheet into one sub bitmap per condition
+  s_weather_atlas = gbitmap_create_with_resource(RESOURCE_ID_WEATHER_ICONS_BLACK_ATLAS);
+  if(s_weather_atlas) {
+    for(int i=0; i<WEATHER_CONDITION_COUNT; i++) {
+      s_weather_icons[i] = gbitmap_create_as_sub_bitmap(s_weather_atlas, GRect(i*WEATHER_ICON_SIZE, 0, WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
+    }
+  }
+  
+  // weather icon, hidden until first weather arrives
+  s_weather_bitmap_layer = create_icon_layer(s_dial_layer, GRect(60, 46, 24, 16), NULL);
+  set_icon_hidden(s_weather_bitmap_layer, true);
+  
+  // digits for temperature, steps and date
+  if(!digits_load(RESOURCE_ID_DIGITS_BLACK_ATLAS)) {
+    LOG_ERROR("out of memory loading digits");
+  }
   
   // create temp text
-  s_temp_layer = text_layer_create(GRect(60, 28, 24, 16));
-  text_layer_set_background_color(s_temp_layer, GColorClear);
-  text_layer_set_text_alignment(s_temp_layer, GTextAlignmentCenter);
-  text_layer_set_font(s_temp_layer, s_font);
-  text_layer_set_text(s_temp_layer, "100");
-  layer_add_child(s_dial_layer, text_layer_get_layer(s_temp_layer));
+  s_temp_layer = create_number_layer(s_dial_layer, GRect(60, 28, 24, 16));
+  set_number(s_temp_layer, 100, 0);
   
   // create battery layer
-  s_battery_circle = layer_create(bounds);
-  layer_set_update_proc(s_battery_circle, battery_update_proc);
-  layer_add_child(s_dial_layer, s_battery_circle);
+  s_battery_circle = create_canvas_layer(s_dial_layer, bounds, battery_update_proc);
   
   // charging icon
   s_charging_bitmap = gbitmap_create_with_resource(RESOURCE_ID_LIGHTENING_BLACK_ICON);
-  s_charging_bitmap_layer = bitmap_layer_create(GRect(36, 76, 14, 14));
-  bitmap_layer_set_compositing_mode(s_charging_bitmap_layer, GCompOpSet);
-  bitmap_layer_set_bitmap(s_charging_bitmap_layer, s_charging_bitmap); 
-  layer_add_child(s_dial_layer, bitmap_layer_get_layer(s_charging_bitmap_layer));    
+  s_charging_bitmap_layer = create_icon_layer(s_dial_layer, GRect(36, 76, 14, 14), s_charging_bitmap);
   
   // bluetooth disconnected icon
   s_bluetooth_bitmap = gbitmap_create_with_resource(RESOURCE_ID_BLUETOOTH_DISCONNECTED_BLACK_ICON);
-  s_bluetooth_bitmap_layer = bitmap_layer_create(GRect(18, 76, 14, 14));
-  bitmap_layer_set_compositing_mode(s_bluetooth_bitmap_layer, GCompOpSet);
-  bitmap_layer_set_bitmap(s_bluetooth_bitmap_layer, s_bluetooth_bitmap); 
-  layer_add_child(s_dial_layer, bitmap_layer_get_layer(s_bluetooth_bitmap_layer));       
+  s_bluetooth_bitmap_layer = create_icon_layer(s_dial_layer, GRect(18, 76, 14, 14), s_bluetooth_bitmap);
   
   // create health layer text
-  s_health_layer = text_layer_create(GRect(54, 108, 36, 16));
-  text_layer_set_background_color(s_health_layer, GColorClear);
-  text_layer_set_text_alignment(s_health_layer, GTextAlignmentCenter);
-  text_layer_set_font(s_health_layer, s_font);
-  layer_add_child(s_dial_layer, text_layer_get_layer(s_health_layer));  
+  s_health_layer = create_number_layer(s_dial_layer, GRect(54, 108, 36, 16));
   
   // create health layer circle
-  s_health_circle = layer_create(bounds);
-  layer_set_update_proc(s_health_circle, health_update_proc);
-  layer_add_child(s_dial_layer, s_health_circle);
+  s_health_circle = create_canvas_layer(s_dial_layer, bounds, health_update_proc);
     
   // create shoe icon
   s_health_bitmap = gbitmap_create_with_resource(RESOURCE_ID_SHOE_BLACK_ICON);
-  s_health_bitmap_layer = bitmap_layer_create(GRect(60, 123, 24, 16));
-  bitmap_layer_set_compositing_mode(s_health_bitmap_layer, GCompOpSet);
-  bitmap_layer_set_bitmap(s_health_bitmap_layer, s_health_bitmap); 
-  layer_add_child(s_dial_layer, bitmap_layer_get_layer(s_health_bitmap_layer));
+  s_health_bitmap_layer = create_icon_layer(s_dial_layer, GRect(60, 123, 24, 16), s_health_bitmap);
   
   // Day Text
-  s_day_text_layer = text_layer_create(GRect(88, 74, 26, 14));
-  text_layer_set_background_color(s_day_text_layer, GColorClear);
-  text_layer_set_text_alignment(s_day_text_layer, GTextAlignmentCenter);
-  text_layer_set_font(s_day_text_layer, s_font);
-  layer_add_child(s_dial_layer, text_layer_get_layer(s_day_text_layer));
+  s_day_text_layer = create_text_layer(s_dial_layer, GRect(88, 74, 26, 14));
   
   // Date text
-  s_date_text_layer = text_layer_create(GRect(113, 74, 16, 14));
-  text_layer_set_background_color(s_date_text_layer, GColorClear);
-  text_layer_set_text_alignment(s_date_text_layer, GTextAlignmentCenter);
-  text_layer_set_font(s_date_text_layer, s_font);
-  layer_add_child(s_dial_layer, text_layer_get_layer(s_date_text_layer));  
+  s_date_text_layer = create_number_layer(s_dial_layer, GRect(113, 74, 16, 14));
     
   // create canvas layer for hands
-  s_hands_layer = layer_create(bounds);
-  layer_set_update_proc(s_hands_layer, ticks_update_proc);
-  layer_add_child(window_layer, s_hands_layer);
+  s_hands_layer = create_canvas_layer(window_layer, bounds, ticks_update_proc);
+  
+  // show current (possibly restored) state on the first frame
+  if(s_face.weather.condition != WEATHER_CONDITION_UNKNOWN) {
+    load_temp();
+    load_icons();
+  }
+  load_steps();
+  if(s_face.mday >= 0) {
+    load_date();
+  }
+  set_icon_hidden(s_charging_bitmap_layer, !s_face.charging);
+  set_icon_hidden(s_bluetooth_bitmap_layer, s_face.connected);
+  PROFILE_HEAP(HEAP_PHASE_AFTER_LOAD);
 }
 
-///////////////////////
-// update clock time //
-///////////////////////
-static void update_time() {
-  // get a tm strucutre
-  time_t temp = time(NULL);
-  struct tm *tick_time = localtime(&temp);
-  
-  // write date to buffer
-  static char date_buffer[16];
-  strftime(date_buffer, sizeof(date_buffer), "%d", tick_time);
-  
-  // write day to buffer
-  static char day_buffer[16];
-  strftime(day_buffer, sizeof(day_buffer), "%a", tick_time);
-  
-  // display this time on the text layer
-  text_layer_set_text(s_date_text_layer, date_buffer);
-  text_layer_set_text(s_day_text_layer, day_buffer);  
+//////////////////////////////////////////
+// apply new time, hands redraw on each //
+// minute, date text only on day change //
+//////////////////////////////////////////
+static void face_set_time(struct tm *tick_time) {
+  if(tick_time->tm_min != s_face.minute || tick_time->tm_hour != s_face.hour) {
+    s_face.minute = tick_time->tm_min;
+    s_face.hour = tick_time->tm_hour;
+    mark_dirty(s_hands_layer);
+  }
+  if(tick_time->tm_sec != s_face.second) {
+    s_face.second = tick_time->tm_sec;
+    if(s_face.seconds_shown) {
+      mark_dirty(s_hands_layer);
+    }
+  }
+  if(tick_time->tm_mday != s_face.mday || tick_time->tm_wday != s_face.wday) {
+    s_face.mday = tick_time->tm_mday;
+    s_face.wday = tick_time->tm_wday;
+    load_date();
+  }
+}
+
+/////////////////////////////////////////
+// apply battery level and charge flag //
+/////////////////////////////////////////
+static void face_set_battery(int8_t percent, bool is_charging) {
+  if(percent != s_face.battery_percent) {
+    s_face.battery_percent = percent;
+    mark_dirty(s_battery_circle);
+  }
+  if(is_charging != s_face.charging) {
+    s_face.charging = is_charging;
+    set_icon_hidden(s_charging_bitmap_layer, !is_charging);
+  }
+}
+
+////////////////////////////
+// apply today's steps    //
+////////////////////////////
+static void face_set_steps(HealthValue steps) {
+  if(steps == s_face.step_count) {
+    return;
+  }
+  // the gauge only needs a redraw if its angle moved, which for goals
+  // above TRIG_MAX_ANGLE steps is not every step
+  int32_t old_angle = gauge_angle_floor(s_face.step_count, step_goal);
+  int32_t new_angle = gauge_angle_floor(steps, step_goal);
+  s_face.step_count = steps;
+  load_steps();
+  if(new_angle != old_angle) {
+    mark_dirty(s_health_circle);
+  }
+}
+
+////////////////////////////////////
+// apply a new step goal          //
+////////////////////////////////////
+static void face_set_step_goal(int32_t goal) {
+  if(goal <= 0 || goal == step_goal) {
+    return;
+  }
+  step_goal = goal;
+  mark_dirty(s_health_circle);
+}
+
+//////////////////////////////////////////
+// apply weather, text and icon update  //
+// only when their own values change    //
+//////////////////////////////////////////
+static void face_set_weather(const WeatherReport *report) {
+  bool temp_changed = report->temperature != s_face.weather.temperature;
+  bool icon_changed = report->condition != s_face.weather.condition;
+  s_face.weather = *report;
+  if(temp_changed || icon_changed) {
+    load_temp();
+  }
+  if(icon_changed) {
+    load_icons();
+  }
+}
+
+////////////////////////////////////
+// apply bluetooth connection,    //
+// returns true if it changed     //
+////////////////////////////////////
+static bool face_set_connected(bool connected) {
+  if(connected == s_face.connected) {
+    return false;
+  }
+  s_face.connected = connected;
+  set_icon_hidden(s_bluetooth_bitmap_layer, connected);
+  return true;
+}
+
+//////////////////////////////////////////
+// rescale the step bars, redraw only   //
+// when a bar's pixel length changes    //
+//////////////////////////////////////////
+static void face_set_histogram(time_t now) {
+  uint32_t steps[HISTOGRAM_HOURS];
+  uint32_t scale = HISTOGRAM_MIN_SCALE;
+  for(int i=0; i<HISTOGRAM_HOURS; i++) {
+    steps[i] = histogram_steps(i, now);
+    scale = MAX(scale, steps[i]);
+  }
+  bool changed = false;
+  for(int i=0; i<HISTOGRAM_HOURS; i++) {
+    uint8_t length = steps[i] * HISTOGRAM_MAX_LENGTH / scale;
+    if(length != s_histogram_lengths[i]) {
+      s_histogram_lengths[i] = length;
+      changed = true;
+    }
+  }
+  if(changed) {
+    mark_dirty(s_histogram_layer);
+  }
+}
+
+//////////////////////////////////////////
+// move the forecast to the current hour //
+// and show it unless a live report is   //
+// fresher than the forecast hour        //
+//////////////////////////////////////////
+static void forecast_apply(time_t now) {
+  if(forecast_advance(now)) {
+    forecast_save();
+  }
+  scheduler_set_forecast(forecast_end());
+  WeatherReport report;
+  if(forecast_current(&report) && report.observed > s_face.weather.observed) {
+    face_set_weather(&report);
+    state_save();
+  }
 }
 
 //////////////////
 // handle ticks //
 //////////////////
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
-  layer_mark_dirty(s_hands_layer);
-  update_time();
+  PROFILE_EVENT(PROFILE_EVENT_TICK);
+  face_set_time(tick_time);
+  // the forecast moves on without the phone
+  if(units_changed & HOUR_UNIT) {
+    forecast_apply(time(NULL));
+    // the bar from 12 hours ago drops off
+    face_set_histogram(time(NULL));
+  }
+  // second ticks only move the seconds hand
+  if(units_changed & MINUTE_UNIT) {
+    update_power_mode();
+    refresh_weather_if_due();
+  }
+}
+
+#if SECONDS_HAND_ENABLED
+///////////////////////////////////////////
+// show or hide the seconds hand, ticks  //
+// run per second only while it is shown //
+///////////////////////////////////////////
+static void face_set_seconds_shown(bool shown) {
+  if(shown == s_face.seconds_shown) {
+    return;
+  }
+  s_face.seconds_shown = shown;
+  tick_timer_service_subscribe(shown ? SECOND_UNIT : MINUTE_UNIT, tick_handler);
+  
+  // pick up the current second right away instead of on the next tick
+  time_t now = time(NULL);
+  face_set_time(localtime(&now));
+  mark_dirty(s_hands_layer);
+}
+
+static void seconds_timeout(void *context) {
+  s_seconds_timer = NULL;
+  face_set_seconds_shown(false);
+}
+
+//////////////////////////////////////////
+// wrist flick shows the seconds hand,  //
+// further flicks extend the window     //
+//////////////////////////////////////////
+static void tap_handler(AccelAxisType axis, int32_t direction) {
+  PROFILE_EVENT(PROFILE_EVENT_TAP);
+  // no second-rate redraws while asleep
+  if(s_face.low_power) {
+    return;
+  }
+  if(s_seconds_timer) {
+    app_timer_reschedule(s_seconds_timer, SECONDS_HAND_DURATION_MS);
+  } else {
+    s_seconds_timer = app_timer_register(SECONDS_HAND_DURATION_MS, seconds_timeout, NULL);
+  }
+  face_set_seconds_shown(true);
 }
+#endif
 
 /////////////////////////////////////
 // registers battery update events //
 /////////////////////////////////////
 static void battery_handler(BatteryChargeState charge_state) {
-  battery_percent = charge_state.charge_percent;
-  if(charge_state.is_charging || charge_state.is_plugged) {
-    charging = true;
-  } else {
-    charging = false;
+  PROFILE_EVENT(PROFILE_EVENT_BATTERY);
+  bool is_charging = charge_state.is_charging || charge_state.is_plugged;
+  face_set_battery(charge_state.charge_percent, is_charging);
+  scheduler_set_battery(charge_state.charge_percent, is_charging);
+}
+
+////////////////////////////////////////////
+// debounced bluetooth status, see link.h //
+////////////////////////////////////////////
+static void link_handler(bool connected, bool alert) {
+  face_set_connected(connected);
+  scheduler_set_connected(connected);
+  if(alert) {
+    PROFILE_EVENT(PROFILE_EVENT_VIBE);
+    vibes_double_pulse();
+  }
+  // the link just became usable, catch up on weather
+  if(connected) {
+    refresh_weather_if_due();
   }
-  // force update to circle
-  layer_mark_dirty(s_battery_circle);
 }
 
-/////////////////////////////
-// manage bluetooth status //
-/////////////////////////////
+// raw connection changes go through the link filter
 static void bluetooth_callback(bool connected) {
-  layer_set_hidden(bitmap_layer_get_layer(s_bluetooth_bitmap_layer), connected);
-  if(!connected) {  
-    vibes_double_pulse();
-  } 
+  PROFILE_EVENT(PROFILE_EVENT_BLUETOOTH);
+  link_raw_update(connected);
+}
+
+//////////////////////////////////////////
+// applies the steps the worker left in //
+// storage, false if there are none     //
+//////////////////////////////////////////
+static bool worker_steps_load() {
+  WorkerSteps steps;
+  if(!persist_exists(PERSIST_KEY_WORKER_STEPS) ||
+     persist_read_data(PERSIST_KEY_WORKER_STEPS, &steps, sizeof(steps)) != (int)sizeof(steps) ||
+     steps.version != WORKER_STEPS_VERSION) {
+    return false;
+  }
+  if(steps.day_start == time_start_of_today()) {
+    face_set_steps(steps.steps_today);
+  }
+  histogram_load(steps.hours, steps.updated);
+  face_set_histogram(time(NULL));
+  return true;
+}
+
+//////////////////////////////////////////
+// storage is only written on hour      //
+// rollover, ask the worker for the     //
+// steps walked since                   //
+//////////////////////////////////////////
+static void worker_request_update() {
+  AppWorkerMessage message = { 0 };
+  app_worker_send_message(WORKER_MSG_REFRESH, &message);
+}
+
+//////////////////////////////////////////
+// re-reads steps once per batch window //
+//////////////////////////////////////////
+static void health_flush(void *context) {
+  s_health_timer = NULL;
+  // the worker already did the reading
+  if(s_worker_running && worker_steps_load()) {
+    worker_request_update();
+    return;
+  }
+  // the system count, minute history lags a few minutes behind it
+  face_set_steps(health_service_sum_today(HealthMetricStepCount));
+  time_t now = time(NULL);
+  if(histogram_update(now)) {
+    face_set_histogram(now);
+  }
+  
+  LOG_DEBUG("health_handler completed");
+}
+
+////////////////////////////////////////////////
+// low power drops to a hands only face,      //
+// pauses health redraws and weather fetches  //
+////////////////////////////////////////////////
+static void face_set_low_power(bool low_power) {
+  if(low_power == s_face.low_power) {
+    return;
+  }
+  s_face.low_power = low_power;
+  set_hidden(s_dial_layer, low_power);
+  scheduler_set_suspended(low_power);
+  
+  if(low_power) {
+    if(s_health_timer) {
+      app_timer_cancel(s_health_timer);
+      s_health_timer = NULL;
+    }
+#if SECONDS_HAND_ENABLED
+    if(s_seconds_timer) {
+      app_timer_cancel(s_seconds_timer);
+      s_seconds_timer = NULL;
+    }
+    face_set_seconds_shown(false);
+#endif
+  } else {
+    // catch up on everything paused while asleep
+    health_flush(NULL);
+    refresh_weather_if_due();
+  }
+  LOG_DEBUG("low power %d", low_power);
+}
+
+/////////////////////////////////////////
+// true inside the quiet window, which //
+// may wrap past midnight              //
+/////////////////////////////////////////
+static bool is_quiet_hour(int hour) {
+  if(s_quiet_start == s_quiet_end) {
+    return false;
+  }
+  if(s_quiet_start < s_quiet_end) {
+    return hour >= s_quiet_start && hour < s_quiet_end;
+  }
+  return hour >= s_quiet_start || hour < s_quiet_end;
+}
+
+//////////////////////////////////////////////
+// enter low power while sleeping or during //
+// quiet hours, leave it on wake            //
+//////////////////////////////////////////////
+static void update_power_mode() {
+  HealthActivityMask activities = health_service_peek_current_activities();
+  bool asleep = activities & (HealthActivitySleep | HealthActivityRestfulSleep);
+  face_set_low_power(asleep || is_quiet_hour(s_face.hour));
 }
 
 // registers health update events
+// movement events start a batch window instead of re-reading each time
 static void health_handler(HealthEventType event, void *context) {
-  if(event==HealthEventMovementUpdate) {
-    step_count = (double)health_service_sum_today(HealthMetricStepCount);
-    
-    // write to char_current_steps variable
-    static char health_buf[16];
-    snprintf(health_buf, sizeof(health_buf), "%d", (int)step_count);
-    char_current_steps = health_buf;
-    text_layer_set_text(s_health_layer, char_current_steps);
-    
-    // force update to circle
-    layer_mark_dirty(s_health_circle);
-    
-    APP_LOG(APP_LOG_LEVEL_INFO, "health_handler completed");
+  PROFILE_EVENT(PROFILE_EVENT_HEALTH);
+  if(event==HealthEventSleepUpdate || event==HealthEventSignificantUpdate) {
+    update_power_mode();
+  }
+  if(event==HealthEventMovementUpdate && !s_health_timer && !s_face.low_power && !s_worker_running) {
+    s_health_timer = app_timer_register(HEALTH_COALESCE_MS, health_flush, NULL);
+  }
+}
+
+// worker pushes fresh steps, storage is only read at launch and on wake
+static void worker_message_handler(uint16_t type, AppWorkerMessage *message) {
+  PROFILE_EVENT(PROFILE_EVENT_WORKER);
+  if(s_face.low_power) {
+    return;
+  }
+  time_t now = time(NULL);
+  if(type == WORKER_MSG_STEPS) {
+    face_set_steps(message->data0 | ((HealthValue)message->data1 << 16));
+    histogram_set_hour(now, message->data2);
+  } else if(type == WORKER_MSG_HOUR_CLOSED) {
+    // sent on the rollover tick, the hour before now is the one that closed
+    histogram_set_hour(now - SECONDS_PER_HOUR, message->data0);
+  } else {
+    return;
   }
+  face_set_histogram(now);
 }
 
+//////////////////////////////////////////////
+// starts the background worker, false if   //
+// it is missing or the user declined it    //
+//////////////////////////////////////////////
+static bool worker_start() {
+  AppWorkerResult result = app_worker_launch();
+  if(result != APP_WORKER_RESULT_SUCCESS && result != APP_WORKER_RESULT_ALREADY_RUNNING) {
+    LOG_INFO("worker unavailable %d, reading health in the face", (int)result);
+    return false;
+  }
+  app_worker_message_subscribe(worker_message_handler);
+  return true;
+}
+
+// destroy helpers, tolerate layers that failed to create
+#define DESTROY(destroy_fn, ptr) do { if(ptr) { destroy_fn(ptr); (ptr) = NULL; } } while(0)
+
 ///////////////////
 // unload window //
 ///////////////////
 static void main_window_unload(Window *window) {
-  layer_destroy(s_dial_layer);
-  layer_destroy(s_hands_layer);
-  layer_destroy(s_temp_circle);
-  layer_destroy(s_battery_circle);
-  layer_destroy(s_health_circle);
-  text_layer_destroy(s_temp_layer);
-  text_layer_destroy(s_health_layer);
-  text_layer_destroy(s_day_text_layer);
-  text_layer_destroy(s_date_text_layer);
-  gbitmap_destroy(s_weather_bitmap);
-  gbitmap_destroy(s_health_bitmap);
-  gbitmap_destroy(s_bluetooth_bitmap);
-  gbitmap_destroy(s_charging_bitmap);
-  gbitmap_destroy(s_bluetooth_bitmap);
-  gpath_destroy(s_minute_arrow);
-  gpath_destroy(s_hour_arrow);
-  gpath_destroy(s_minute_filler);
-  gpath_destroy(s_hour_filler);
-}
-
-//////////////////////////////////////
-// display appropriate weather icon //
-//////////////////////////////////////
-static void load_icons() {
-  // populate icon variable
-    if(strcmp(icon_layer_buf, "clear-day")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_CLEAR_SKY_DAY_BLACK_ICON);  
-    } else if(strcmp(icon_layer_buf, "clear-night")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_CLEAR_SKY_NIGHT_BLACK_ICON);
-    }else if(strcmp(icon_layer_buf, "rain")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_RAIN_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "snow")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_SNOW_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "sleet")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_SLEET_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "wind")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_WIND_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "fog")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_FOG_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "cloudy")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_CLOUDY_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "partly-cloudy-day")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_PARTLY_CLOUDY_DAY_BLACK_ICON);
-    } else if(strcmp(icon_layer_buf, "partly-cloudy-night")==0) {
-      s_weather_bitmap = gbitmap_create_with_resource(RESOURCE_ID_PARTLY_CLOUDY_NIGHT_BLACK_ICON);
-    }
-  // populate weather icon
-  s_weather_bitmap_layer = bitmap_layer_create(GRect(60, 46, 24, 16));
-  bitmap_layer_set_compositing_mode(s_weather_bitmap_layer, GCompOpSet);  
-  bitmap_layer_set_bitmap(s_weather_bitmap_layer, s_weather_bitmap); 
-  layer_add_child(s_dial_layer, bitmap_layer_get_layer(s_weather_bitmap_layer)); 
+  DESTROY(layer_destroy, s_hands_layer);
+  DESTROY(layer_destroy, s_temp_circle);
+  DESTROY(layer_destroy, s_battery_circle);
+  DESTROY(layer_destroy, s_health_circle);
+  DESTROY(layer_destroy, s_histogram_layer);
+  DESTROY(layer_destroy, s_temp_layer);
+  DESTROY(layer_destroy, s_health_layer);
+  DESTROY(text_layer_destroy, s_day_text_layer);
+  DESTROY(layer_destroy, s_date_text_layer);
+  DESTROY(bitmap_layer_destroy, s_weather_bitmap_layer);
+  DESTROY(bitmap_layer_destroy, s_charging_bitmap_layer);
+  DESTROY(bitmap_layer_destroy, s_bluetooth_bitmap_layer);
+  DESTROY(bitmap_layer_destroy, s_health_bitmap_layer);
+  DESTROY(layer_destroy, s_dial_layer);
+  DESTROY(gbitmap_destroy, s_dial_cache);
+  s_dial_cache_valid = false;
+  for(int i=0; i<WEATHER_CONDITION_COUNT; i++) {
+    DESTROY(gbitmap_destroy, s_weather_icons[i]);
+  }
+  DESTROY(gbitmap_destroy, s_weather_atlas);
+  digits_unload();
+  DESTROY(gbitmap_destroy, s_health_bitmap);
+  DESTROY(gbitmap_destroy, s_bluetooth_bitmap);
+  DESTROY(gbitmap_destroy, s_charging_bitmap);
 }
 
 ///////////////////
 // weather calls //
 ///////////////////
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
-  // Store incoming information
-  static char temp_buf[8];
-  static char icon_buf[32];
-  static char temp_layer_buf[32];
-
-  // Read tuples for data
-  Tuple *temp_tuple = dict_find(iterator, KEY_TEMP);
-  Tuple *icon_tuple = dict_find(iterator, KEY_ICON);  
+  PROFILE_EVENT(PROFILE_EVENT_INBOX);
+  // Read tuple for data
+  Tuple *weather_tuple = dict_find(iterator, KEY_WEATHER);
 
-  // If all data is available, use it
-  if(temp_tuple && icon_tuple) {
-    
-    // temp
-    snprintf(temp_buf, sizeof(temp_buf), "%d", (int)temp_tuple->value->int32);
-    snprintf(temp_layer_buf, sizeof(temp_layer_buf), "%s", temp_buf);
-    text_layer_set_text(s_temp_layer, temp_layer_buf);
-
-    // icon
-    snprintf(icon_buf, sizeof(icon_buf), "%s", icon_tuple->value->cstring);
-    snprintf(icon_layer_buf, sizeof(icon_layer_buf), "%s", icon_buf);    
-  }  
+  // If data is available and well formed, use it
+  WeatherReport report;
+  if(weather_tuple && weather_tuple->type == TUPLE_BYTE_ARRAY &&
+     weather_decode(weather_tuple->value->data, weather_tuple->length, &report)) {
+    face_set_weather(&report);
+    state_save();
+    scheduler_weather_received(report.observed, time(NULL));
+  }
+  
+  // hourly forecast replaces the whole ring
+  Tuple *forecast_tuple = dict_find(iterator, KEY_FORECAST);
+  if(forecast_tuple && forecast_tuple->type == TUPLE_BYTE_ARRAY &&
+     forecast_decode(forecast_tuple->value->data, forecast_tuple->length)) {
+    forecast_save();
+    forecast_apply(time(NULL));
+  }
+  
+  // step goal configured on the phone
+  Tuple *goal_tuple = dict_find(iterator, KEY_STEP_GOAL);
+  if(goal_tuple && goal_tuple->value->int32 != step_goal && goal_tuple->value->int32 > 0) {
+    face_set_step_goal(goal_tuple->value->int32);
+    state_save();
+  }
+  
+  // disconnect alert grace configured on the phone, in seconds
+  Tuple *grace_tuple = dict_find(iterator, KEY_DISCONNECT_GRACE);
+  if(grace_tuple && grace_tuple->value->int32 > 0) {
+    link_set_disconnect_grace(grace_tuple->value->int32 * 1000);
+  }
+  
+  // weather refresh interval configured on the phone, in minutes
+  Tuple *interval_tuple = dict_find(iterator, KEY_REFRESH_INTERVAL);
+  if(interval_tuple && interval_tuple->value->int32 >= 0) {
+    // clamped before narrowing, a huge value must not wrap to a short one
+    scheduler_set_base_interval(MIN(interval_tuple->value->int32, SCHEDULER_MAX_INTERVAL));
+  }
+  
+  // quiet hours configured on the phone
+  Tuple *quiet_start_tuple = dict_find(iterator, KEY_QUIET_START);
+  Tuple *quiet_end_tuple = dict_find(iterator, KEY_QUIET_END);
+  // hours outside 0-23 are rejected, they would never match a clock hour
+  if(quiet_start_tuple && quiet_end_tuple &&
+     quiet_start_tuple->value->int32 >= 0 && quiet_start_tuple->value->int32 < 24 &&
+     quiet_end_tuple->value->int32 >= 0 && quiet_end_tuple->value->int32 < 24) {
+    s_quiet_start = quiet_start_tuple->value->int32;
+    s_quiet_end = quiet_end_tuple->value->int32;
+    update_power_mode();
+  }
   
-  load_icons();
-  APP_LOG(APP_LOG_LEVEL_INFO, "inbox_received_callback");
+  // phone is up, only ask it for weather if ours is due for refresh
+  if(dict_find(iterator, KEY_JS_READY)) {
+    refresh_weather_if_due();
+  }
+  
+#if PROFILE_ENABLED
+  // phone asked for the profiling counters, after any weather request
+  if(dict_find(iterator, KEY_PROFILE_REQUEST)) {
+    send_profile();
+  }
+#endif
+  
+  LOG_DEBUG("inbox_received_callback");
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
-  APP_LOG(APP_LOG_LEVEL_ERROR, "Message dropped!");
+  LOG_ERROR("Message dropped! %d", (int)reason);
+  // the phone retries on its own, but if it gave up the scheduler
+  // asks again after its backoff instead of waiting a full interval,
+  // a drop with no request out was not the weather report
+  if(scheduler_get_stats()->pending) {
+    scheduler_request_failed(time(NULL));
+  }
 }
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
-  APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed!");
+  LOG_ERROR("Outbox send failed!");
+#if PROFILE_ENABLED
+  // a lost dump is not a failed weather request
+  if(profile_outbox_done()) {
+    return;
+  }
+#endif
+  scheduler_request_failed(time(NULL));
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-  APP_LOG(APP_LOG_LEVEL_INFO, "Outbox send success!");
+  PROFILE_EVENT(PROFILE_EVENT_OUTBOX);
+  LOG_DEBUG("Outbox send success!");
+#if PROFILE_ENABLED
+  if(profile_outbox_done()) {
+    return;
+  }
+#endif
+  scheduler_request_acked();
 }
 
 ////////////////////
@@ -507,6 +1253,13 @@ static void init() {
     .unload = main_window_unload
   });
   
+  // restore last known weather and steps before the first frame
+  state_restore();
+  scheduler_init(s_face.weather.condition == WEATHER_CONDITION_UNKNOWN ? 0 : s_face.weather.observed);
+  // catch the forecast up with the hours spent closed
+  forecast_restore();
+  forecast_apply(time(NULL));
+  
   // show window on the watch with animated=true
   window_stack_push(s_main_window, true);
   
@@ -514,27 +1267,28 @@ static void init() {
   tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
   
   // Make sure the time is displayed from the start
-  update_time();
+  time_t now = time(NULL);
+  face_set_time(localtime(&now));
   
-  // init hand paths
-  s_minute_arrow = gpath_create(&MINUTE_HAND_POINTS);
-  s_minute_filler = gpath_create(&MINUTE_HAND_FILLER);
-  s_hour_arrow = gpath_create(&HOUR_HAND_POINTS);
-  s_hour_filler = gpath_create(&HOUR_HAND_FILLER);
+#if SECONDS_HAND_ENABLED
+  // wrist flick brings up the seconds hand
+  accel_tap_service_subscribe(tap_handler);
+#endif
   
-  // move hands to proper locations
-  Layer *window_layer = window_get_root_layer(s_main_window);
-  GRect bounds = layer_get_bounds(window_layer);
-  GPoint center = grect_center_point(&bounds);
-  gpath_move_to(s_minute_arrow, center);
-  gpath_move_to(s_minute_filler, center);
-  gpath_move_to(s_hour_arrow, center);    
-  gpath_move_to(s_hour_filler, center);   
-    
   // subscribe to health events 
   health_service_events_subscribe(health_handler, NULL); 
-  // force initial update
-  health_handler(HealthEventMovementUpdate, NULL);   
+  // steps come precomputed from the worker, otherwise backfill the
+  // step bars here, updates after this read new minutes only
+  s_worker_running = worker_start();
+  if(!s_worker_running || !worker_steps_load()) {
+    histogram_init(now);
+    face_set_histogram(now);
+    // force initial update
+    health_flush(NULL);
+  } else {
+    worker_request_update();
+  }
+  update_power_mode();
     
   // register with Battery State Service
   battery_state_service_subscribe(battery_handler);
@@ -545,7 +1299,11 @@ static void init() {
   connection_service_subscribe((ConnectionHandlers) {
     .pebble_app_connection_handler = bluetooth_callback
   });
-  bluetooth_callback(connection_service_peek_pebble_app_connection());  
+  // launch state is applied as is, weather waits for the ready message
+  bool connected = connection_service_peek_pebble_app_connection();
+  link_init(connected, link_handler);
+  face_set_connected(connected);
+  scheduler_set_connected(connected);
   
   // Register weather callbacks
   app_message_register_inbox_received(inbox_received_callback);
@@ -554,16 +1312,43 @@ static void init() {
   app_message_register_outbox_sent(outbox_sent_callback);  
   
   // Open AppMessage for weather callbacks
-  const int inbox_size = 64;
-  const int outbox_size = 64;
+  // inbox holds the larger of a weather tuple with a full forecast or the
+  // ready message (ready flag, step goal, quiet start/end, disconnect grace,
+  // refresh interval, profile request),
+  // outbox holds exactly one weather request or, with profiling on, one dump
+  const int inbox_size = MAX(dict_calc_buffer_size(2, WEATHER_PAYLOAD_SIZE,
+                                                   FORECAST_PAYLOAD_SIZE(FORECAST_MAX_HOURS)),
+                             dict_calc_buffer_size(7, sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+                                                   sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+                                                   sizeof(int32_t)));
+#if PROFILE_ENABLED
+  const int outbox_size = dict_calc_buffer_size(1, PROFILE_DUMP_SIZE);
+#else
+  const int outbox_size = dict_calc_buffer_size(1, sizeof(uint8_t));
+#endif
   app_message_open(inbox_size, outbox_size);  
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Clock show_clock_window");  
+  LOG_DEBUG("Clock show_clock_window");  
 }
 
 ///////////////////////
 // de-initialize app //
 ///////////////////////
 static void deinit() {
+  if(s_health_timer) {
+    app_timer_cancel(s_health_timer);
+  }
+#if SECONDS_HAND_ENABLED
+  if(s_seconds_timer) {
+    app_timer_cancel(s_seconds_timer);
+  }
+  accel_tap_service_unsubscribe();
+#endif
+  link_deinit();
+  // the worker keeps running after the face closes
+  if(s_worker_running) {
+    app_worker_message_unsubscribe();
+  }
+  state_save();
   window_destroy(s_main_window);
 }
 
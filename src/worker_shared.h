@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+//////////////////////////////////////////////////
+// state shared with the background worker in   //
+// worker_src/, included by both sides so it    //
+// must not depend on pebble.h                  //
+//////////////////////////////////////////////////
+#define WORKER_STEPS_VERSION 1
+#define PERSIST_KEY_WORKER_STEPS 3
+#define WORKER_HOURS 12
+
+// steps walked in one local clock hour
+typedef struct {
+  time_t start;      // local start of the hour this bucket counts
+  uint32_t steps;
+} StepHour;
+
+// written by the worker when an hour closes and when it stops, read by
+// the face at launch and on wake
+typedef struct {
+  uint8_t version;
+  time_t updated;                 // health was read up to here
+  time_t day_start;               // day steps_today belongs to
+  int32_t steps_today;
+  StepHour hours[WORKER_HOURS];   // indexed by clock hour, 0-11
+} WorkerSteps;
+
+// worker to face message types, the face keeps its buckets current from
+// these and only reads the persisted hours at launch and on wake
+// WORKER_MSG_STEPS: data0/data1 low/high half of steps today, data2 steps
+// in the current hour
+#define WORKER_MSG_STEPS 1
+// WORKER_MSG_HOUR_CLOSED: data0 final steps of the hour that just ended,
+// sent on rollover ahead of the first WORKER_MSG_STEPS of the new hour
+#define WORKER_MSG_HOUR_CLOSED 2
+
+// face to worker message types
+// WORKER_MSG_REFRESH: no data, the face launched or woke up and storage
+// may be an hour old, the worker answers with WORKER_MSG_STEPS
+#define WORKER_MSG_REFRESH 3
@@ -0,0 +1,106 @@
+#pragma once
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "host.h"
+
+///////////////////////////////////////////////////
+// the face compiled into the test, so tests can //
+// call its handlers and read its statics        //
+///////////////////////////////////////////////////
+// main() falls off the end, fine for main but not once renamed
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main watchface_main
+#include "../src/watchface.c"
+#undef main
+#pragma GCC diagnostic pop
+
+// Saturday 2026-03-14 00:00 UTC, the day every scenario plays on
+#define FACE_DAY 1773446400
+#define FACE_AT(hour, minute, second) \
+  ((time_t)FACE_DAY + (hour) * SECONDS_PER_HOUR + (minute) * SECONDS_PER_MINUTE + (second))
+
+//////////////////////////////////////////
+// names the face's layers for the      //
+// counter tables                       //
+//////////////////////////////////////////
+static inline void face_name_layers() {
+  host_name_layer(s_dial_layer, "dial");
+  host_name_layer(s_histogram_layer, "histogram");
+  host_name_layer(s_temp_circle, "temp circle");
+  host_name_layer(s_temp_layer, "temp digits");
+  host_name_layer(s_battery_circle, "battery");
+  host_name_layer(s_health_layer, "step digits");
+  host_name_layer(s_health_circle, "health");
+  host_name_layer(s_day_text_layer ? text_layer_get_layer(s_day_text_layer) : NULL, "day text");
+  host_name_layer(s_date_text_layer, "date digits");
+  host_name_layer(s_hands_layer, "hands");
+  host_name_layer(s_weather_bitmap_layer ? bitmap_layer_get_layer(s_weather_bitmap_layer) : NULL, "weather icon");
+  host_name_layer(s_charging_bitmap_layer ? bitmap_layer_get_layer(s_charging_bitmap_layer) : NULL, "charging icon");
+  host_name_layer(s_bluetooth_bitmap_layer ? bitmap_layer_get_layer(s_bluetooth_bitmap_layer) : NULL, "bluetooth icon");
+  host_name_layer(s_health_bitmap_layer ? bitmap_layer_get_layer(s_health_bitmap_layer) : NULL, "shoe icon");
+}
+
+static inline void face_print_counters(FILE *out, const char *title) {
+  HostLayerCounters counters[32];
+  int count = host_layer_counters(counters, 32);
+  uint32_t draws = 0, pixels = 0, trig = 0;
+  fprintf(out, "%s\n  %-16s %8s %8s %8s %8s\n", title, "layer", "renders", "draws", "pixels", "trig");
+  for(int i=0; i<count; i++) {
+    fprintf(out, "  %-16s %8u %8u %8u %8u\n", counters[i].name, counters[i].renders, counters[i].draws,
+            counters[i].pixels, counters[i].trig);
+    draws += counters[i].draws;
+    pixels += counters[i].pixels;
+    trig += counters[i].trig;
+  }
+  fprintf(out, "  %-16s %8u %8u %8u %8u\n", "total", host_events()->frames, draws, pixels, trig);
+}
+
+//////////////////////////////////////////
+// phone messages, as app.js sends them //
+//////////////////////////////////////////
+static inline void face_send_weather(uint8_t condition, int16_t temperature, time_t observed) {
+  uint8_t payload[WEATHER_PAYLOAD_SIZE] = {
+    WEATHER_PROTOCOL_VERSION, condition, temperature & 0xFF, (temperature >> 8) & 0xFF,
+    observed & 0xFF, (observed >> 8) & 0xFF, (observed >> 16) & 0xFF, (observed >> 24) & 0xFF, 0
+  };
+  dict_write_data(host_inbox_begin(), KEY_WEATHER, payload, sizeof(payload));
+  host_inbox_deliver();
+}
+
+static inline void face_send_goal(int32_t goal) {
+  dict_write_int32(host_inbox_begin(), KEY_STEP_GOAL, goal);
+  host_inbox_deliver();
+}
+
+static inline void face_send_ready() {
+  dict_write_int32(host_inbox_begin(), KEY_JS_READY, 1);
+  host_inbox_deliver();
+}
+
+//////////////////////////////////////////
+// runs a scenario in a child process   //
+// so every one starts on a fresh watch //
+// with fresh statics, returns its exit //
+// status, 128 + signal if it crashed   //
+//////////////////////////////////////////
+static inline int face_run_isolated(int (*scenario)(const void *arg), const void *arg) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if(pid == 0) {
+    int result = scenario(arg);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(result);
+  }
+  int status = 0;
+  if(pid < 0 || waitpid(pid, &status, 0) < 0) {
+    return 1;
+  }
+  if(WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,127 @@
+#include "host.h"
+#include "gauge.h"
+
+///////////////////////////////////////////////////
+// renders both radial gauges with the original  //
+// float sweep and with the fixed-point one from //
+// src/gauge.c and checks the frames match pixel //
+// for pixel, then checks the span fill matches  //
+// the radial fill at every angle                //
+///////////////////////////////////////////////////
+#define BATTERY_BOUNDS GRect(16, 66, GAUGE_DIAMETER, GAUGE_DIAMETER)
+#define HEALTH_BOUNDS GRect(54, 104, GAUGE_DIAMETER, GAUGE_DIAMETER)
+#define FRAME_BYTES (HOST_ROW_BYTES * HOST_SCREEN_HEIGHT)
+
+static const int32_t GOALS[] = { 1, 7, 100, 1000, 5000, 8000, 10000, 12345, 30000, 100000 };
+
+static Layer *s_gauge_layer;
+static GRect s_bounds;
+static int32_t s_angle_start, s_angle_end;
+static bool s_radial;      // graphics_fill_radial instead of gauge_fill
+
+static void gauge_update_proc(Layer *layer, GContext *ctx) {
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  if(s_radial) {
+    graphics_fill_radial(ctx, s_bounds, GOvalScaleModeFitCircle, GAUGE_THICKNESS, s_angle_start, s_angle_end);
+  } else {
+    gauge_fill(ctx, s_bounds, s_angle_start, s_angle_end);
+  }
+}
+
+static void render(GRect bounds, int32_t angle_start, int32_t angle_end, uint8_t *frame) {
+  s_bounds = bounds;
+  s_angle_start = angle_start;
+  s_angle_end = angle_end;
+  layer_mark_dirty(s_gauge_layer);
+  host_render();
+  memcpy(frame, host_frame_buffer(), FRAME_BYTES);
+}
+
+static int differing_pixels(const uint8_t *a, const uint8_t *b) {
+  int count = 0;
+  for(int i=0; i<FRAME_BYTES; i++) {
+    count += __builtin_popcount(a[i] ^ b[i]);
+  }
+  return count;
+}
+
+//////////////////////////////////////////
+// the float expressions the gauges     //
+// used before src/gauge.c              //
+//////////////////////////////////////////
+static int32_t float_battery_start(int percent) {
+  return DEG_TO_TRIGANGLE(360-(percent*3.6));
+}
+
+static int32_t float_steps_end(double steps, int32_t goal) {
+  return DEG_TO_TRIGANGLE((steps/goal)*360);
+}
+
+static int check(const char *gauge, int32_t value, int32_t max, GRect bounds,
+                 int32_t float_start, int32_t float_end, int32_t fixed_start, int32_t fixed_end) {
+  static uint8_t expected[FRAME_BYTES], actual[FRAME_BYTES];
+  render(bounds, float_start, float_end, expected);
+  render(bounds, fixed_start, fixed_end, actual);
+  int differences = differing_pixels(expected, actual);
+  if(differences) {
+    printf("FAIL %s %d/%d: %d pixels differ\n", gauge, (int)value, (int)max, differences);
+    return 1;
+  }
+  return 0;
+}
+
+//////////////////////////////////////////
+// the span fill against the radial     //
+// fill, health fills from 0 and the    //
+// battery up to a full turn            //
+//////////////////////////////////////////
+static int check_spans(const char *gauge, GRect bounds, int32_t angle, bool from_zero) {
+  static uint8_t expected[FRAME_BYTES], actual[FRAME_BYTES];
+  int32_t start = from_zero ? 0 : angle, end = from_zero ? angle : TRIG_MAX_ANGLE;
+  s_radial = true;
+  render(bounds, start, end, expected);
+  s_radial = false;
+  uint32_t draws = host_layer_get_counters(s_gauge_layer)->draws;
+  render(bounds, start, end, actual);
+  if(host_layer_get_counters(s_gauge_layer)->draws != draws) {
+    printf("FAIL %s angle %d: gauge_fill fell back to graphics_fill_radial\n", gauge, (int)angle);
+    return 1;
+  }
+  int differences = differing_pixels(expected, actual);
+  if(differences) {
+    printf("FAIL %s angle %d: span fill differs from the radial fill in %d pixels\n", gauge, (int)angle,
+           differences);
+    return 1;
+  }
+  return 0;
+}
+
+int main() {
+  host_init(0);
+  Window *window = window_create();
+  s_gauge_layer = layer_create(GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  layer_set_update_proc(s_gauge_layer, gauge_update_proc);
+  layer_add_child(window_get_root_layer(window), s_gauge_layer);
+  window_stack_push(window, false);
+
+  int failures = 0, cases = 0;
+  for(int percent=0; percent<=100; percent++, cases++) {
+    failures += check("battery", percent, 100, BATTERY_BOUNDS,
+                      float_battery_start(percent), TRIG_MAX_ANGLE,
+                      TRIG_MAX_ANGLE - gauge_angle_ceil(percent, 100), TRIG_MAX_ANGLE);
+  }
+  // every step count up to the goal, the old code overshot past it
+  for(size_t g=0; g<sizeof(GOALS)/sizeof(GOALS[0]); g++) {
+    int32_t goal = GOALS[g];
+    for(int32_t steps=0; steps<=goal; steps++, cases++) {
+      failures += check("steps", steps, goal, HEALTH_BOUNDS,
+                        0, float_steps_end(steps, goal), 0, gauge_angle_floor(steps, goal));
+    }
+  }
+  for(int32_t angle=0; angle<=TRIG_MAX_ANGLE; angle++, cases+=2) {
+    failures += check_spans("battery", BATTERY_BOUNDS, angle, false);
+    failures += check_spans("steps", HEALTH_BOUNDS, angle, true);
+  }
+  printf("gauge: %d of %d failed\n", failures, cases);
+  return failures ? 1 : 0;
+}
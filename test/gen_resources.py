@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# Decodes the bitmap resources listed in package.json into 1-bit planes
+# for the host build, ids are numbered in media order like the SDK does.
+#
+import json
+import os.path
+import struct
+import sys
+import zlib
+
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    assert data[:8] == b'\x89PNG\r\n\x1a\n', path
+    offset = 8
+    idat = b''
+    palette = []
+    transparency = b''
+    while offset < len(data):
+        length, kind = struct.unpack('>I4s', data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', body)
+        elif kind == b'PLTE':
+            palette = [tuple(bytearray(body[i:i + 3])) for i in range(0, length, 3)]
+        elif kind == b'tRNS':
+            transparency = bytearray(body)
+        elif kind == b'IDAT':
+            idat += body
+        offset += 12 + length
+    assert depth == 8 and not interlace, '{}: only 8-bit non-interlaced PNGs are supported'.format(path)
+
+    channels = CHANNELS[color]
+    stride = width * channels
+    raw = bytearray(zlib.decompress(idat))
+    rows = []
+    previous = bytearray(stride)
+    for y in range(height):
+        kind = raw[y * (stride + 1)]
+        row = raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)]
+        for x in range(stride):
+            a = row[x - channels] if x >= channels else 0
+            b = previous[x]
+            c = previous[x - channels] if x >= channels else 0
+            row[x] = (row[x] + [0, a, b, (a + b) // 2, paeth(a, b, c)][kind]) & 0xFF
+        rows.append(row)
+        previous = row
+
+    pixels = []
+    for row in rows:
+        line = []
+        for x in range(width):
+            p = row[x * channels:(x + 1) * channels]
+            if color == 0:
+                rgba = (p[0], p[0], p[0], 255)
+            elif color == 2:
+                rgba = (p[0], p[1], p[2], 255)
+            elif color == 3:
+                r, g, b = palette[p[0]]
+                rgba = (r, g, b, transparency[p[0]] if p[0] < len(transparency) else 255)
+            elif color == 4:
+                rgba = (p[0], p[0], p[0], p[1])
+            else:
+                rgba = tuple(p)
+            line.append(rgba)
+        pixels.append(line)
+    return width, height, pixels
+
+
+def planes(width, height, pixels):
+    # 1 is white / opaque, rows word aligned, LSB is the leftmost pixel
+    row_bytes = (width + 31) // 32 * 4
+    data = bytearray(row_bytes * height)
+    alpha = bytearray(row_bytes * height)
+    opaque = True
+    for y in range(height):
+        for x in range(width):
+            r, g, b, a = pixels[y][x]
+            bit = 1 << (x & 7)
+            if (r * 299 + g * 587 + b * 114) // 1000 >= 128:
+                data[y * row_bytes + x // 8] |= bit
+            if a >= 128:
+                alpha[y * row_bytes + x // 8] |= bit
+            else:
+                opaque = False
+    return row_bytes, data, None if opaque else alpha
+
+
+def c_bytes(name, data):
+    lines = ['static const uint8_t {}[{}] = {{'.format(name, len(data))]
+    for i in range(0, len(data), 16):
+        lines.append('  {},'.format(', '.join('0x{:02x}'.format(v) for v in data[i:i + 16])))
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main(package, resources, out_dir):
+    with open(package) as f:
+        media = json.load(f)['pebble']['resources']['media']
+    ids = []
+    sources = []
+    entries = []
+    for index, item in enumerate(media, 1):
+        name = item['name']
+        ids.append('#define RESOURCE_ID_{} {}'.format(name, index))
+        if item['type'] != 'bitmap':
+            continue
+        width, height, pixels = read_png(os.path.join(resources, item['file']))
+        row_bytes, data, alpha = planes(width, height, pixels)
+        sources.append(c_bytes('{}_DATA'.format(name), data))
+        if alpha:
+            sources.append(c_bytes('{}_ALPHA'.format(name), alpha))
+        entries.append('  {{RESOURCE_ID_{0}, {1}, {2}, {3}, {0}_DATA, {4}}},'.format(
+            name, width, height, row_bytes, '{}_ALPHA'.format(name) if alpha else 'NULL'))
+
+    with open(os.path.join(out_dir, 'resource_ids.auto.h'), 'w') as f:
+        f.write('// generated by test/gen_resources.py, do not edit\n#pragma once\n\n' + '\n'.join(ids) + '\n')
+    with open(os.path.join(out_dir, 'resources.c'), 'w') as f:
+        f.write('// generated by test/gen_resources.py, do not edit\n#include "host.h"\n\n')
+        f.write('\n\n'.join(sources))
+        f.write('\n\nstatic const HostResource RESOURCES[] = {\n' + '\n'.join(entries) + '\n};\n\n')
+        f.write('const HostResource *host_resource(uint32_t id) {\n'
+                '  for(size_t i=0; i<sizeof(RESOURCES)/sizeof(RESOURCES[0]); i++) {\n'
+                '    if(RESOURCES[i].id == id) {\n'
+                '      return &RESOURCES[i];\n'
+                '    }\n'
+                '  }\n'
+                '  return NULL;\n'
+                '}\n')
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:4])
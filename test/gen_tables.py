@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+#
+# Writes the geometry tables outside waf, with the same generator the
+# firmware build runs from wscript.
+#
+import sys
+
+
+class Output(object):
+    def __init__(self, path):
+        self.path = path
+
+    def write(self, text):
+        with open(self.path, 'w') as f:
+            f.write(text)
+
+
+class Task(object):
+    def __init__(self, path):
+        self.outputs = [Output(path)]
+
+
+def main(wscript, output):
+    rules = {'__file__': wscript}
+    with open(wscript) as f:
+        exec(compile(f.read(), wscript, 'exec'), rules)
+    rules['generate_geometry_tables'](Task(output))
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:3])
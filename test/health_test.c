@@ -0,0 +1,191 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// walks the step count up to past the goal and  //
+// checks the health gauge is marked dirty when  //
+// its angle moves, so the host frame never goes //
+// stale, then walks through a day checking the  //
+// total takes one health sum per batch and the  //
+// bars none, and with the worker running that   //
+// both come from its messages alone             //
+///////////////////////////////////////////////////
+static const int32_t GOALS[] = { 100, 2500, 8000 };
+
+static int redraw_run(const void *arg) {
+  int32_t goal = *(const int32_t *)arg;
+  host_init(FACE_AT(12, 0, 0));
+  init();
+  face_name_layers();
+  face_send_goal(goal);
+  host_render();
+
+  const HostLayerCounters *gauge = host_layer_get_counters(s_health_circle);
+  Layer *root = window_get_root_layer(s_main_window);
+  uint32_t drawn = 0;
+  int failures = 0, redraws = 0;
+  for(int32_t steps=1; steps<=goal+goal/10; steps++) {
+    uint32_t marks = gauge->marks;
+    bool moved = gauge_angle_floor(steps, goal) != gauge_angle_floor(s_face.step_count, goal);
+    face_set_steps(steps);
+    bool marked = gauge->marks != marks;
+
+    // render every step, the gauge grows from 0 so the same pixel
+    // count means the same pixels
+    uint32_t pixels = gauge->pixels;
+    layer_mark_dirty(root);
+    host_render();
+    uint32_t previous = drawn;
+    drawn = gauge->pixels - pixels;
+    redraws += marked;
+    if(marked != moved) {
+      printf("FAIL goal %d, %d steps: %s but the angle %s\n", (int)goal, (int)steps,
+             marked ? "marked dirty" : "not marked", moved ? "moved" : "did not move");
+      failures++;
+    }
+    if(drawn != previous && !marked) {
+      printf("FAIL goal %d, %d steps: the gauge went from %u to %u pixels without a redraw\n", (int)goal, (int)steps,
+             previous, drawn);
+      failures++;
+    }
+  }
+  printf("%s goal %d: %d gauge redraws over %d step changes\n", failures ? "FAIL" : "ok  ", (int)goal, redraws,
+         (int)(goal + goal / 10));
+  return failures ? 1 : 0;
+}
+
+//////////////////////////////////////////
+// launch at start, walk a minute on    //
+// and a minute off until end, flushing //
+// every batch window                   //
+//////////////////////////////////////////
+typedef struct {
+  const char *name;
+  time_t start;
+  time_t end;
+} Walk;
+
+static const Walk WALKS[] = {
+  { "afternoon", FACE_AT(12, 0, 0), FACE_AT(16, 0, 0) },
+  { "past midnight", FACE_AT(22, 30, 0), FACE_AT(25, 30, 0) },
+};
+
+static int walk_run(const void *arg) {
+  const Walk *walk = arg;
+  host_init(walk->start);
+  for(time_t t=FACE_DAY; t<walk->end; t+=2 * SECONDS_PER_MINUTE) {
+    host_health_walk(t, t + SECONDS_PER_MINUTE, 40 + t / SECONDS_PER_MINUTE % 60);
+  }
+  init();
+  face_name_layers();
+  host_render();
+
+  int failures = 0;
+  uint32_t sums = host_health_reads()->sums, flushes = 0;
+  while(host_now() < walk->end) {
+    host_health_event(HealthEventMovementUpdate);
+    host_advance_ms(HEALTH_COALESCE_MS);
+    host_render();
+    flushes++;
+    HealthValue today = health_service_sum_today(HealthMetricStepCount);
+    sums++;
+    if(s_face.step_count != today) {
+      printf("FAIL %s, %u min in: shows %d steps, health sums %d\n", walk->name,
+             (unsigned)(host_now() - walk->start) / SECONDS_PER_MINUTE, (int)s_face.step_count, (int)today);
+      failures++;
+      break;
+    }
+    host_advance_ms(60 * 1000 - HEALTH_COALESCE_MS);
+  }
+  uint32_t face_sums = host_health_reads()->sums - sums;
+  uint32_t trig = host_layer_get_counters(s_histogram_layer)->trig;
+  if(face_sums != flushes) {
+    printf("FAIL %s: %u health sums over %u batches\n", walk->name, face_sums, flushes);
+    failures++;
+  }
+  if(trig) {
+    printf("FAIL %s: step bars took %u trig lookups\n", walk->name, trig);
+    failures++;
+  }
+  printf("%s %s: %u health sums over %u batches, %u trig lookups\n", failures ? "FAIL" : "ok  ",
+         walk->name, face_sums, flushes, trig);
+  return failures ? 1 : 0;
+}
+
+//////////////////////////////////////////
+// with the worker running, storage is  //
+// read at launch and on wake only      //
+//////////////////////////////////////////
+static int worker_run(const void *arg) {
+  const char *name = "worker";
+  host_init(FACE_AT(9, 30, 0));
+  host_worker_launch_result(APP_WORKER_RESULT_SUCCESS);
+  WorkerSteps stored = {
+    .version = WORKER_STEPS_VERSION,
+    .updated = host_now(),
+    .day_start = FACE_DAY,
+    .steps_today = 1000,
+  };
+  stored.hours[9] = (StepHour) { .start = FACE_AT(9, 0, 0), .steps = 100 };
+  persist_write_data(PERSIST_KEY_WORKER_STEPS, &stored, sizeof(stored));
+  init();
+  face_name_layers();
+  host_render();
+
+  int failures = 0;
+  uint32_t reads = host_persist_reads(PERSIST_KEY_WORKER_STEPS);
+  // storage can be an hour old, the face asks for the steps since
+  uint32_t launch_requests = host_worker_sent();
+  bool launch_refresh = host_worker_last_type() == WORKER_MSG_REFRESH;
+  int32_t today = stored.steps_today;
+  // what the worker sends walking 50 steps a minute for two hours
+  for(int m=0; m<2 * 60; m++) {
+    host_advance_ms(60 * 1000);
+    today += 50;
+    struct tm *local = localtime(&(time_t) { host_now() });
+    if(local->tm_min == 0) {
+      host_worker_message(WORKER_MSG_HOUR_CLOSED, &(AppWorkerMessage) { .data0 = 3000 });
+    }
+    AppWorkerMessage message = { .data0 = today & 0xFFFF, .data1 = today >> 16, .data2 = 50 * (local->tm_min + 1) };
+    host_worker_message(WORKER_MSG_STEPS, &message);
+  }
+  if(s_face.step_count != today || histogram_steps(11, host_now()) != 50 * 31 ||
+     histogram_steps(10, host_now()) != 3000) {
+    printf("FAIL %s: messages left %d steps today, %u and %u in the last two hours\n", name,
+           (int)s_face.step_count, histogram_steps(10, host_now()), histogram_steps(11, host_now()));
+    failures++;
+  }
+  uint32_t message_reads = host_persist_reads(PERSIST_KEY_WORKER_STEPS) - reads;
+  host_health_set_sleeping(true);
+  host_health_event(HealthEventSleepUpdate);
+  uint32_t sent = host_worker_sent();
+  host_health_set_sleeping(false);
+  host_health_event(HealthEventSleepUpdate);
+  uint32_t wake_reads = host_persist_reads(PERSIST_KEY_WORKER_STEPS) - reads - message_reads;
+  uint32_t wake_requests = host_worker_sent() - sent;
+  if(launch_requests != 1 || !launch_refresh || wake_requests != 1 ||
+     host_worker_last_type() != WORKER_MSG_REFRESH) {
+    printf("FAIL %s: %u refresh requests at launch, %u on wake\n", name, launch_requests, wake_requests);
+    failures++;
+  }
+  if(reads != 1 || message_reads || wake_reads != 1) {
+    printf("FAIL %s: %u storage reads at launch, %u over 120 messages, %u on wake\n", name, reads, message_reads,
+           wake_reads);
+    failures++;
+  }
+  printf("%s %s: %u storage reads at launch, %u over 120 messages, %u on wake\n", failures ? "FAIL" : "ok  ", name,
+         reads, message_reads, wake_reads);
+  return failures ? 1 : 0;
+}
+
+int main() {
+  int failures = 0;
+  for(size_t i=0; i<sizeof(GOALS)/sizeof(GOALS[0]); i++) {
+    failures += face_run_isolated(redraw_run, &GOALS[i]) != 0;
+  }
+  for(size_t i=0; i<sizeof(WALKS)/sizeof(WALKS[0]); i++) {
+    failures += face_run_isolated(walk_run, &WALKS[i]) != 0;
+  }
+  failures += face_run_isolated(worker_run, NULL) != 0;
+  printf("health: %d failed\n", failures);
+  return failures ? 1 : 0;
+}
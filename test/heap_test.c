@@ -0,0 +1,153 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// heap per window lifecycle phase, leaks across //
+// repeated load/unload and weather updates, and //
+// a failed allocation at every point of load    //
+// and the first frame. Timers are left out, a   //
+// pending AppTimer is not a leak                //
+///////////////////////////////////////////////////
+#define LIFECYCLE_CYCLES 20
+#define WEATHER_UPDATES 10
+
+static const uint8_t CONDITIONS[] = {
+  WEATHER_CLEAR_DAY, WEATHER_RAIN, WEATHER_SNOW, WEATHER_FOG, WEATHER_WIND, WEATHER_CLOUDY
+};
+
+static size_t objects() {
+  return host_heap_used(HOST_HEAP_OBJECT);
+}
+
+static void weather_updates(int count) {
+  for(int i=0; i<count; i++) {
+    host_advance_ms(30 * 60 * 1000);
+    face_send_weather(CONDITIONS[i % sizeof(CONDITIONS)], -5 + i * 3, host_now());
+  }
+}
+
+static int lifecycle_run(const void *arg) {
+  host_init(FACE_AT(9, 0, 0));
+  init();
+  size_t loaded = objects();
+  host_render();
+  size_t first_frame = objects();
+  weather_updates(1);
+  size_t after_weather = objects();
+  window_stack_pop(false);
+  size_t unloaded = objects();
+  size_t window_bytes = first_frame - unloaded;
+  printf("     heap after load %u, first frame %u, weather %u, unload %u, peak %u\n", (unsigned)loaded,
+         (unsigned)first_frame, (unsigned)after_weather, (unsigned)unloaded, (unsigned)host_heap_peak());
+
+  int failures = 0;
+  if(window_bytes > HEAP_BUDGET_BYTES) {
+    printf("FAIL window takes %u bytes, budget is %u\n", (unsigned)window_bytes, HEAP_BUDGET_BYTES);
+    failures++;
+  }
+  if(after_weather != first_frame) {
+    printf("FAIL first weather update left %d bytes\n", (int)(after_weather - first_frame));
+    failures++;
+  }
+  for(int cycle=0; cycle<LIFECYCLE_CYCLES; cycle++) {
+    window_stack_push(s_main_window, false);
+    host_render();
+    weather_updates(WEATHER_UPDATES);
+    if(objects() != first_frame) {
+      printf("FAIL cycle %d: loaded window holds %d bytes more than the first\n", cycle,
+             (int)(objects() - first_frame));
+      failures++;
+    }
+    window_stack_pop(false);
+    if(objects() != unloaded) {
+      printf("FAIL cycle %d: unload left %d bytes\n", cycle, (int)(objects() - unloaded));
+      failures++;
+    }
+  }
+  window_stack_push(s_main_window, false);
+  deinit();
+  if(objects()) {
+    printf("FAIL deinit left %u bytes\n", (unsigned)objects());
+    failures++;
+  }
+  printf("%s %d load/unload cycles, %d weather updates each\n", failures ? "FAIL" : "ok  ", LIFECYCLE_CYCLES,
+         WEATHER_UPDATES);
+  return failures ? 1 : 0;
+}
+
+//////////////////////////////////////////
+// allocations made by the window load  //
+// and the first frame, [first, last)   //
+//////////////////////////////////////////
+typedef struct {
+  uint32_t first;
+  uint32_t last;
+} AllocationRange;
+
+static AllocationRange s_load_allocations;
+
+static void relaunch_window() {
+  host_init(FACE_AT(9, 0, 0));
+  init();
+  window_stack_pop(false);
+}
+
+static int failure_run(const void *arg) {
+  uint32_t index = *(const uint32_t *)arg;
+  relaunch_window();
+  size_t unloaded = objects();
+  host_heap_fail_at(index);
+  window_stack_push(s_main_window, false);
+  host_render();
+  host_heap_fail_at(-1);
+
+  // whatever loaded has to keep working and unload cleanly
+  weather_updates(2);
+  host_tap();
+  host_advance_ms(2 * 60 * 1000);
+  window_stack_pop(false);
+  if(objects() != unloaded) {
+    printf("FAIL allocation %u failed: unload left %d bytes\n", index, (int)(objects() - unloaded));
+    return 1;
+  }
+  // and a later load without the failure is whole again
+  window_stack_push(s_main_window, false);
+  host_render();
+  deinit();
+  if(objects()) {
+    printf("FAIL allocation %u failed: deinit left %u bytes\n", index, (unsigned)objects());
+    return 1;
+  }
+  return 0;
+}
+
+static int range_run(const void *arg) {
+  relaunch_window();
+  AllocationRange range = { .first = host_heap_allocations() };
+  window_stack_push(s_main_window, false);
+  host_render();
+  range.last = host_heap_allocations();
+  // the parent only needs the two indices, pass them through a pipe
+  return write(*(const int *)arg, &range, sizeof(range)) == sizeof(range) ? 0 : 1;
+}
+
+int main() {
+  int failures = face_run_isolated(lifecycle_run, NULL) != 0;
+
+  int pipe_fds[2];
+  if(pipe(pipe_fds) || face_run_isolated(range_run, &pipe_fds[1]) ||
+     read(pipe_fds[0], &s_load_allocations, sizeof(s_load_allocations)) != sizeof(s_load_allocations)) {
+    printf("FAIL could not count load allocations\n");
+    return 1;
+  }
+  for(uint32_t index=s_load_allocations.first; index<s_load_allocations.last; index++) {
+    int status = face_run_isolated(failure_run, &index);
+    if(status > 128) {
+      printf("FAIL allocation %u failed: crashed with signal %d\n", index, status - 128);
+    }
+    failures += status != 0;
+  }
+  printf("%s %u failed allocations in load and first frame\n", failures ? "FAIL" : "ok  ",
+         s_load_allocations.last - s_load_allocations.first);
+  printf("heap: %d failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,1776 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include "host.h"
+
+// heap header, keeps payloads aligned like malloc
+typedef union {
+  struct {
+    size_t size;
+    HostHeapTag tag;
+  } info;
+  long double align;
+} HeapHeader;
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  bool hidden;
+  LayerUpdateProc update_proc;
+  Layer *parent;
+  Layer *children;
+  Layer *next;
+  void *data;
+  HostLayerCounters counters;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+  GColor background;
+  GColor text_color;
+  GTextAlignment alignment;
+  GFont font;
+};
+
+struct BitmapLayer {
+  Layer layer;
+  const GBitmap *bitmap;
+  GCompOp compositing;
+};
+
+struct Window {
+  Layer root;
+  GColor background;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config;
+  bool loaded;
+};
+
+struct GBitmap {
+  uint8_t *data;
+  uint8_t *alpha;
+  uint16_t row_bytes;
+  GRect bounds;
+  GBitmapFormat format;
+  bool owns_data;
+};
+
+struct GContext {
+  GColor fill;
+  GColor stroke;
+  uint8_t stroke_width;
+  GCompOp compositing;
+  GPoint offset;
+  GRect clip;
+  Layer *layer;
+};
+
+struct AppTimer {
+  uint64_t due;
+  AppTimerCallback callback;
+  void *data;
+  AppTimer *next;
+};
+
+// largest dictionary the host builds, well above any app message size
+#define HOST_DICT_MAX 512
+#define HOST_TUPLE_HEADER 7
+
+struct DictionaryIterator {
+  uint8_t buffer[HOST_DICT_MAX];
+  uint32_t size;
+  uint32_t used;
+};
+
+#define HOST_PERSIST_KEYS 32
+#define HOST_PERSIST_MAX 1024
+#define HOST_OUTBOX_LOG 256
+// minutes of step history held, centered on the start time
+#define HOST_HEALTH_DAYS 6
+
+typedef struct {
+  bool slot;         // key assigned, counts kept even without data
+  uint32_t key;
+  bool used;
+  size_t size;
+  uint8_t data[HOST_PERSIST_MAX];
+  uint32_t reads;
+  uint32_t writes;
+} PersistEntry;
+
+typedef enum {
+  OUTBOX_IDLE,
+  OUTBOX_BEGUN,
+  OUTBOX_IN_FLIGHT
+} OutboxState;
+
+static uint64_t s_now_ms;
+static HostEvents s_events;
+
+static size_t s_heap_used[HOST_HEAP_TAG_COUNT];
+static size_t s_heap_peak;
+static uint32_t s_heap_allocations;
+static int32_t s_heap_fail_at = -1;
+
+// word aligned like the firmware's, src/gauge.c writes it a word at a time
+static uint8_t s_frame_buffer[HOST_SCREEN_HEIGHT * HOST_ROW_BYTES] __attribute__((aligned(4)));
+// frame buffer as it was captured, to count the pixels written directly
+static uint8_t s_frame_captured[HOST_SCREEN_HEIGHT * HOST_ROW_BYTES];
+static GBitmap s_frame_bitmap;
+static GContext s_ctx;
+static Window *s_window;
+static bool s_dirty;
+static uint32_t s_trig_outside;
+
+static AppTimer *s_timers;
+static TickHandler s_tick_handler;
+static TimeUnits s_tick_units;
+static AccelTapHandler s_tap_handler;
+static BatteryStateHandler s_battery_handler;
+static BatteryChargeState s_battery;
+static ConnectionHandler s_connection_handler;
+static bool s_connected;
+static ClickHandler s_single_click[NUM_BUTTONS];
+static ClickHandler s_long_click[NUM_BUTTONS];
+
+static PersistEntry s_persist[HOST_PERSIST_KEYS];
+
+static HealthEventHandler s_health_handler;
+static void *s_health_context;
+static uint8_t s_steps[HOST_HEALTH_DAYS * 24 * 60];
+static time_t s_steps_base;
+static bool s_sleeping;
+static HostHealthReads s_health_reads;
+
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static uint32_t s_inbox_size;
+static uint32_t s_outbox_size;
+static DictionaryIterator s_inbox;
+static DictionaryIterator s_outbox;
+static OutboxState s_outbox_state;
+static HostOutboxMode s_outbox_mode;
+static uint64_t s_outbox_due;
+static DictionaryIterator s_outbox_log[HOST_OUTBOX_LOG];
+static uint32_t s_outbox_count;
+
+static AppWorkerResult s_worker_result;
+static AppWorkerMessageHandler s_worker_handler;
+static AppWorkerMessage s_worker_last;
+static uint8_t s_worker_last_type;
+static uint32_t s_worker_sent;
+
+/////////////////////////////////////////////
+// setup                                   //
+/////////////////////////////////////////////
+void host_init(time_t start) {
+  // localtime() is UTC so scenarios do not depend on the machine
+  setenv("TZ", "UTC", 1);
+  tzset();
+  s_now_ms = (uint64_t)start * 1000;
+  s_steps_base = start - start % SECONDS_PER_DAY - (HOST_HEALTH_DAYS / 2) * SECONDS_PER_DAY;
+  s_frame_bitmap = (GBitmap) {
+    .data = s_frame_buffer,
+    .row_bytes = HOST_ROW_BYTES,
+    .bounds = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT),
+    .format = GBitmapFormat1Bit
+  };
+  memset(s_frame_buffer, 0xFF, sizeof(s_frame_buffer));
+  s_battery = (BatteryChargeState) { .charge_percent = 100 };
+  s_connected = true;
+  s_worker_result = APP_WORKER_RESULT_NO_WORKER;
+  s_heap_fail_at = -1;
+}
+
+/////////////////////////////////////////////
+// heap                                    //
+/////////////////////////////////////////////
+static void *host_alloc(size_t size, HostHeapTag tag) {
+  uint32_t index = s_heap_allocations++;
+  if((int32_t)index == s_heap_fail_at) {
+    return NULL;
+  }
+  HeapHeader *header = calloc(1, sizeof(HeapHeader) + size);
+  if(!header) {
+    return NULL;
+  }
+  header->info.size = size;
+  header->info.tag = tag;
+  s_heap_used[tag] += size;
+  size_t used = heap_bytes_used();
+  if(used > s_heap_peak) {
+    s_heap_peak = used;
+  }
+  return header + 1;
+}
+
+static void host_free(void *ptr) {
+  if(!ptr) {
+    return;
+  }
+  HeapHeader *header = (HeapHeader *)ptr - 1;
+  s_heap_used[header->info.tag] -= header->info.size;
+  free(header);
+}
+
+size_t heap_bytes_used(void) {
+  size_t used = 0;
+  for(int i=0; i<HOST_HEAP_TAG_COUNT; i++) {
+    used += s_heap_used[i];
+  }
+  return used;
+}
+
+size_t heap_bytes_free(void) {
+  // diorite leaves apps about 64k
+  return 64 * 1024 - heap_bytes_used();
+}
+
+size_t host_heap_used(HostHeapTag tag) {
+  return s_heap_used[tag];
+}
+
+size_t host_heap_peak() {
+  return s_heap_peak;
+}
+
+void host_heap_reset_peak() {
+  s_heap_peak = heap_bytes_used();
+}
+
+uint32_t host_heap_allocations() {
+  return s_heap_allocations;
+}
+
+void host_heap_fail_at(int32_t index) {
+  s_heap_fail_at = index;
+}
+
+/////////////////////////////////////////////
+// clock                                   //
+/////////////////////////////////////////////
+time_t host_time(time_t *t) {
+  time_t now = (time_t)(s_now_ms / 1000);
+  if(t) {
+    *t = now;
+  }
+  return now;
+}
+
+time_t host_now() {
+  return host_time(NULL);
+}
+
+uint64_t host_now_ms() {
+  return s_now_ms;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  uint16_t ms = s_now_ms % 1000;
+  if(t_utc) {
+    *t_utc = host_now();
+  }
+  if(out_ms) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+time_t time_start_of_today(void) {
+  time_t now = host_now();
+  struct tm *local = localtime(&now);
+  return now - local->tm_hour * SECONDS_PER_HOUR - local->tm_min * SECONDS_PER_MINUTE - local->tm_sec;
+}
+
+const HostEvents *host_events() {
+  return &s_events;
+}
+
+/////////////////////////////////////////////
+// trig, same rounding as the wscript      //
+// tables                                  //
+/////////////////////////////////////////////
+static void count_trig() {
+  if(s_ctx.layer) {
+    s_ctx.layer->counters.trig++;
+  } else {
+    s_trig_outside++;
+  }
+}
+
+int32_t sin_lookup(int32_t angle) {
+  count_trig();
+  return (int32_t)lround(sin(2 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  count_trig();
+  return (int32_t)lround(cos(2 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x) {
+  count_trig();
+  int32_t angle = (int32_t)(atan2(y, x) / (2 * M_PI) * TRIG_MAX_ANGLE);
+  return angle < 0 ? angle + TRIG_MAX_ANGLE : angle;
+}
+
+uint32_t host_trig_outside_render() {
+  return s_trig_outside;
+}
+
+GPoint grect_center_point(const GRect *rect) {
+  return GPoint(rect->origin.x + rect->size.w / 2, rect->origin.y + rect->size.h / 2);
+}
+
+bool gsize_equal(const GSize *size_a, const GSize *size_b) {
+  return size_a->w == size_b->w && size_a->h == size_b->h;
+}
+
+static GRect grect_intersect(GRect a, GRect b) {
+  int x0 = MAX(a.origin.x, b.origin.x);
+  int y0 = MAX(a.origin.y, b.origin.y);
+  int x1 = MIN(a.origin.x + a.size.w, b.origin.x + b.size.w);
+  int y1 = MIN(a.origin.y + a.size.h, b.origin.y + b.size.h);
+  return GRect(x0, y0, MAX(0, x1 - x0), MAX(0, y1 - y0));
+}
+
+/////////////////////////////////////////////
+// pixels                                  //
+/////////////////////////////////////////////
+static bool bitmap_bit(const uint8_t *data, uint16_t row_bytes, int x, int y) {
+  return (data[y * row_bytes + (x >> 3)] >> (x & 7)) & 1;
+}
+
+static void frame_put(int x, int y, bool white) {
+  uint8_t *byte = &s_frame_buffer[y * HOST_ROW_BYTES + (x >> 3)];
+  if(white) {
+    *byte |= 1 << (x & 7);
+  } else {
+    *byte &= ~(1 << (x & 7));
+  }
+}
+
+bool host_pixel(int x, int y) {
+  return bitmap_bit(s_frame_buffer, HOST_ROW_BYTES, x, y);
+}
+
+const uint8_t *host_frame_buffer() {
+  return s_frame_buffer;
+}
+
+// writes one pixel in layer coordinates, clipped to the layer
+static void plot(GContext *ctx, int x, int y, GColor color) {
+  x += ctx->offset.x;
+  y += ctx->offset.y;
+  if(color == GColorClear ||
+     x < ctx->clip.origin.x || x >= ctx->clip.origin.x + ctx->clip.size.w ||
+     y < ctx->clip.origin.y || y >= ctx->clip.origin.y + ctx->clip.size.h) {
+    return;
+  }
+  frame_put(x, y, color == GColorWhite);
+  if(ctx->layer) {
+    ctx->layer->counters.pixels++;
+  }
+}
+
+static bool peek(GContext *ctx, int x, int y) {
+  return host_pixel(x + ctx->offset.x, y + ctx->offset.y);
+}
+
+static void count_draw(GContext *ctx) {
+  if(ctx->layer) {
+    ctx->layer->counters.draws++;
+  }
+}
+
+static void hline(GContext *ctx, int x0, int x1, int y, GColor color) {
+  for(int x=x0; x<=x1; x++) {
+    plot(ctx, x, y, color);
+  }
+}
+
+static void thin_line(GContext *ctx, GPoint p0, GPoint p1, GColor color) {
+  int dx = abs(p1.x - p0.x), sx = p0.x < p1.x ? 1 : -1;
+  int dy = -abs(p1.y - p0.y), sy = p0.y < p1.y ? 1 : -1;
+  int err = dx + dy;
+  int x = p0.x, y = p0.y;
+  for(;;) {
+    plot(ctx, x, y, color);
+    if(x == p1.x && y == p1.y) {
+      break;
+    }
+    int e2 = 2 * err;
+    if(e2 >= dy) {
+      err += dy;
+      x += sx;
+    }
+    if(e2 <= dx) {
+      err += dx;
+      y += sy;
+    }
+  }
+}
+
+// wide strokes have round caps, every pixel within half the width
+static void wide_line(GContext *ctx, GPoint p0, GPoint p1, uint8_t width, GColor color) {
+  double radius = width / 2.0;
+  int reach = (width + 1) / 2;
+  double vx = p1.x - p0.x, vy = p1.y - p0.y;
+  double length2 = vx * vx + vy * vy;
+  for(int y=MIN(p0.y, p1.y)-reach; y<=MAX(p0.y, p1.y)+reach; y++) {
+    for(int x=MIN(p0.x, p1.x)-reach; x<=MAX(p0.x, p1.x)+reach; x++) {
+      double t = length2 ? ((x - p0.x) * vx + (y - p0.y) * vy) / length2 : 0;
+      t = t < 0 ? 0 : t > 1 ? 1 : t;
+      double ex = p0.x + t * vx - x, ey = p0.y + t * vy - y;
+      if(ex * ex + ey * ey <= radius * radius) {
+        plot(ctx, x, y, color);
+      }
+    }
+  }
+}
+
+static void stroke_line(GContext *ctx, GPoint p0, GPoint p1) {
+  if(ctx->stroke_width > 1) {
+    wide_line(ctx, p0, p1, ctx->stroke_width, ctx->stroke);
+  } else {
+    thin_line(ctx, p0, p1, ctx->stroke);
+  }
+}
+
+// midpoint circle, one octant mirrored into the quadrants in mask
+static void circle_points(GContext *ctx, GPoint c, int radius, GCornerMask mask, GColor color) {
+  int x = radius, y = 0, err = 1 - radius;
+  while(x >= y) {
+    if(mask & GCornerBottomRight) {
+      plot(ctx, c.x + x, c.y + y, color);
+      plot(ctx, c.x + y, c.y + x, color);
+    }
+    if(mask & GCornerBottomLeft) {
+      plot(ctx, c.x - x, c.y + y, color);
+      plot(ctx, c.x - y, c.y + x, color);
+    }
+    if(mask & GCornerTopRight) {
+      plot(ctx, c.x + x, c.y - y, color);
+      plot(ctx, c.x + y, c.y - x, color);
+    }
+    if(mask & GCornerTopLeft) {
+      plot(ctx, c.x - x, c.y - y, color);
+      plot(ctx, c.x - y, c.y - x, color);
+    }
+    y++;
+    if(err < 0) {
+      err += 2 * y + 1;
+    } else {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+}
+
+/////////////////////////////////////////////
+// graphics context                        //
+/////////////////////////////////////////////
+static void context_reset(GContext *ctx) {
+  ctx->fill = GColorBlack;
+  ctx->stroke = GColorBlack;
+  ctx->stroke_width = 1;
+  ctx->compositing = GCompOpAssign;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill = color;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke = color;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+  ctx->stroke_width = stroke_width ? stroke_width : 1;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+  // no effect on a 1-bit screen
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->compositing = mode;
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  count_draw(ctx);
+  plot(ctx, point.x, point.y, ctx->stroke);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  count_draw(ctx);
+  stroke_line(ctx, p0, p1);
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  graphics_draw_round_rect(ctx, rect, 0);
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  count_draw(ctx);
+  int r = corner_radius;
+  int x0 = rect.origin.x, y0 = rect.origin.y;
+  int x1 = x0 + rect.size.w - 1, y1 = y0 + rect.size.h - 1;
+  for(int y=y0; y<=y1; y++) {
+    for(int x=x0; x<=x1; x++) {
+      // rounded corners drop pixels outside their quarter circle
+      int cx = x < x0 + r ? x0 + r : x > x1 - r ? x1 - r : x;
+      int cy = y < y0 + r ? y0 + r : y > y1 - r ? y1 - r : y;
+      GCornerMask corner = (cy < y ? (cx < x ? GCornerBottomRight : GCornerBottomLeft)
+                                   : (cx < x ? GCornerTopRight : GCornerTopLeft));
+      if((cx != x && cy != y) && (corner_mask & corner) &&
+         (x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r) {
+        continue;
+      }
+      plot(ctx, x, y, ctx->fill);
+    }
+  }
+}
+
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius) {
+  count_draw(ctx);
+  int r = radius;
+  int x0 = rect.origin.x, y0 = rect.origin.y;
+  int x1 = x0 + rect.size.w - 1, y1 = y0 + rect.size.h - 1;
+  hline(ctx, x0 + r, x1 - r, y0, ctx->stroke);
+  hline(ctx, x0 + r, x1 - r, y1, ctx->stroke);
+  for(int y=y0+r; y<=y1-r; y++) {
+    plot(ctx, x0, y, ctx->stroke);
+    plot(ctx, x1, y, ctx->stroke);
+  }
+  if(r) {
+    circle_points(ctx, GPoint(x0 + r, y0 + r), r, GCornerTopLeft, ctx->stroke);
+    circle_points(ctx, GPoint(x1 - r, y0 + r), r, GCornerTopRight, ctx->stroke);
+    circle_points(ctx, GPoint(x0 + r, y1 - r), r, GCornerBottomLeft, ctx->stroke);
+    circle_points(ctx, GPoint(x1 - r, y1 - r), r, GCornerBottomRight, ctx->stroke);
+  }
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  count_draw(ctx);
+  circle_points(ctx, p, radius, GCornersAll, ctx->stroke);
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  count_draw(ctx);
+  int r = radius;
+  for(int dy=-r; dy<=r; dy++) {
+    int half = (int)sqrt((double)(r * r - dy * dy));
+    hline(ctx, p.x - half, p.x + half, p.y + dy, ctx->fill);
+  }
+}
+
+////////////////////////////////////////////////
+// ring pixels are those whose centers lie    //
+// between the inner and outer radius, angles //
+// clockwise from 12 o'clock, the same model  //
+// as the gauge tables in wscript             //
+////////////////////////////////////////////////
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset_thickness,
+                          int32_t angle_start, int32_t angle_end) {
+  count_draw(ctx);
+  int diameter = MIN(rect.size.w, rect.size.h);
+  int inner_diameter = MAX(0, diameter - 2 * inset_thickness);
+  int outer = diameter * diameter;
+  int inner = inner_diameter * inner_diameter;
+  for(int y=0; y<rect.size.h; y++) {
+    int dy = 2 * y + 1 - rect.size.h;
+    for(int x=0; x<rect.size.w; x++) {
+      int dx = 2 * x + 1 - rect.size.w;
+      int d2 = dx * dx + dy * dy;
+      if(d2 < inner || d2 >= outer) {
+        continue;
+      }
+      int32_t angle = (int32_t)(atan2(dx, -dy) / (2 * M_PI) * TRIG_MAX_ANGLE);
+      angle = (angle % TRIG_MAX_ANGLE + TRIG_MAX_ANGLE) % TRIG_MAX_ANGLE;
+      if(angle >= angle_start && angle < angle_end) {
+        plot(ctx, rect.origin.x + x, rect.origin.y + y, ctx->fill);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////
+// bitmaps                                 //
+/////////////////////////////////////////////
+static GBitmap *bitmap_alloc(GSize size, bool alpha) {
+  uint16_t row_bytes = ((size.w + 31) / 32) * 4;
+  size_t plane = (size_t)row_bytes * size.h;
+  GBitmap *bitmap = host_alloc(sizeof(GBitmap) + plane * (alpha ? 2 : 1), HOST_HEAP_OBJECT);
+  if(!bitmap) {
+    return NULL;
+  }
+  bitmap->data = (uint8_t *)(bitmap + 1);
+  bitmap->alpha = alpha ? bitmap->data + plane : NULL;
+  bitmap->row_bytes = row_bytes;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->format = GBitmapFormat1Bit;
+  bitmap->owns_data = true;
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  return bitmap_alloc(size, false);
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  const HostResource *resource = host_resource(resource_id);
+  if(!resource) {
+    return NULL;
+  }
+  GBitmap *bitmap = bitmap_alloc(GSize(resource->width, resource->height), resource->alpha != NULL);
+  if(!bitmap) {
+    return NULL;
+  }
+  size_t plane = (size_t)resource->row_bytes * resource->height;
+  memcpy(bitmap->data, resource->data, plane);
+  if(resource->alpha) {
+    bitmap->format = GBitmapFormat1BitPalette;
+    memcpy(bitmap->alpha, resource->alpha, plane);
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+  GBitmap *bitmap = host_alloc(sizeof(GBitmap), HOST_HEAP_OBJECT);
+  if(!bitmap) {
+    return NULL;
+  }
+  *bitmap = *base_bitmap;
+  bitmap->owns_data = false;
+  bitmap->bounds = grect_intersect(base_bitmap->bounds, GRect(base_bitmap->bounds.origin.x + sub_rect.origin.x,
+                                                              base_bitmap->bounds.origin.y + sub_rect.origin.y,
+                                                              sub_rect.size.w, sub_rect.size.h));
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  host_free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->row_bytes;
+}
+
+// GCompOpSet draws only the opaque pixels of bitmaps with transparency,
+// on plain 1-bit bitmaps it paints white wherever the source is black
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  count_draw(ctx);
+  int width = bitmap->bounds.size.w, height = bitmap->bounds.size.h;
+  if(!width || !height) {
+    return;
+  }
+  for(int y=0; y<rect.size.h; y++) {
+    for(int x=0; x<rect.size.w; x++) {
+      // larger rects tile the bitmap
+      int sx = bitmap->bounds.origin.x + x % width;
+      int sy = bitmap->bounds.origin.y + y % height;
+      bool src = bitmap_bit(bitmap->data, bitmap->row_bytes, sx, sy);
+      int dx = rect.origin.x + x, dy = rect.origin.y + y;
+      bool dst = peek(ctx, dx, dy);
+      bool out;
+      switch(ctx->compositing) {
+        case GCompOpAssignInverted: out = !src; break;
+        case GCompOpOr: out = src || dst; break;
+        case GCompOpAnd: out = src && dst; break;
+        case GCompOpClear: out = src ? false : dst; break;
+        case GCompOpSet:
+          if(bitmap->alpha) {
+            if(!bitmap_bit(bitmap->alpha, bitmap->row_bytes, sx, sy)) {
+              continue;
+            }
+            out = src;
+          } else {
+            out = src ? dst : true;
+          }
+          break;
+        default: out = src; break;
+      }
+      plot(ctx, dx, dy, out ? GColorWhite : GColorBlack);
+    }
+  }
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  memcpy(s_frame_captured, s_frame_buffer, sizeof(s_frame_buffer));
+  return &s_frame_bitmap;
+}
+
+// direct writes count as the pixels they changed
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  if(buffer != &s_frame_bitmap) {
+    return false;
+  }
+  if(ctx->layer) {
+    for(size_t i=0; i<sizeof(s_frame_buffer); i++) {
+      ctx->layer->counters.pixels += __builtin_popcount(s_frame_buffer[i] ^ s_frame_captured[i]);
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////
+// paths                                   //
+/////////////////////////////////////////////
+static void path_points(GPath *path, GPoint *out) {
+  int32_t sine = path->rotation ? sin_lookup(path->rotation) : 0;
+  int32_t cosine = path->rotation ? cos_lookup(path->rotation) : TRIG_MAX_RATIO;
+  for(uint32_t i=0; i<path->num_points; i++) {
+    GPoint p = path->points[i];
+    if(path->rotation) {
+      p = GPoint(p.x * cosine / TRIG_MAX_RATIO - p.y * sine / TRIG_MAX_RATIO,
+                 p.y * cosine / TRIG_MAX_RATIO + p.x * sine / TRIG_MAX_RATIO);
+    }
+    out[i] = GPoint(p.x + path->offset.x, p.y + path->offset.y);
+  }
+}
+
+static int compare_double(const void *a, const void *b) {
+  double da = *(const double *)a, db = *(const double *)b;
+  return da < db ? -1 : da > db;
+}
+
+// even-odd scanline fill, edges include their top row
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+  count_draw(ctx);
+  if(path->num_points < 3) {
+    return;
+  }
+  GPoint points[path->num_points];
+  path_points(path, points);
+  int top = points[0].y, bottom = points[0].y;
+  for(uint32_t i=1; i<path->num_points; i++) {
+    top = MIN(top, points[i].y);
+    bottom = MAX(bottom, points[i].y);
+  }
+  double crossings[path->num_points];
+  for(int y=top; y<=bottom; y++) {
+    int count = 0;
+    for(uint32_t i=0; i<path->num_points; i++) {
+      GPoint a = points[i], b = points[(i + 1) % path->num_points];
+      if(a.y == b.y || y < MIN(a.y, b.y) || y >= MAX(a.y, b.y)) {
+        continue;
+      }
+      crossings[count++] = a.x + (double)(y - a.y) * (b.x - a.x) / (b.y - a.y);
+    }
+    qsort(crossings, count, sizeof(double), compare_double);
+    for(int i=0; i+1<count; i+=2) {
+      hline(ctx, (int)lround(crossings[i]), (int)lround(crossings[i + 1]), y, ctx->fill);
+    }
+  }
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+  count_draw(ctx);
+  if(!path->num_points) {
+    return;
+  }
+  GPoint points[path->num_points];
+  path_points(path, points);
+  for(uint32_t i=0; i<path->num_points; i++) {
+    stroke_line(ctx, points[i], points[(i + 1) % path->num_points]);
+  }
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return font_key;
+}
+
+/////////////////////////////////////////////
+// layers                                  //
+/////////////////////////////////////////////
+static void layer_init(Layer *layer, GRect frame) {
+  layer->frame = frame;
+  layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+}
+
+Layer *layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = host_alloc(sizeof(Layer) + data_size, HOST_HEAP_OBJECT);
+  if(!layer) {
+    return NULL;
+  }
+  layer_init(layer, frame);
+  layer->data = data_size ? (void *)(layer + 1) : NULL;
+  return layer;
+}
+
+static void layer_remove(Layer *layer) {
+  if(layer->parent) {
+    Layer **link = &layer->parent->children;
+    while(*link && *link != layer) {
+      link = &(*link)->next;
+    }
+    if(*link) {
+      *link = layer->next;
+    }
+    s_dirty = true;
+  }
+  for(Layer *child=layer->children; child; child=child->next) {
+    child->parent = NULL;
+  }
+  layer->parent = NULL;
+  layer->next = NULL;
+  layer->children = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+  if(layer) {
+    layer_remove(layer);
+    host_free(layer);
+  }
+}
+
+void *layer_get_data(const Layer *layer) {
+  return layer->data;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  layer->counters.marks++;
+  s_dirty = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  if(layer->hidden != hidden) {
+    layer->hidden = hidden;
+    s_dirty = true;
+  }
+}
+
+bool layer_get_hidden(const Layer *layer) {
+  return layer->hidden;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  child->parent = parent;
+  child->next = NULL;
+  Layer **link = &parent->children;
+  while(*link) {
+    link = &(*link)->next;
+  }
+  *link = child;
+  s_dirty = true;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void host_name_layer(Layer *layer, const char *name) {
+  if(layer) {
+    layer->counters.name = name;
+  }
+}
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+  TextLayer *text_layer = (TextLayer *)layer;
+  if(text_layer->background != GColorClear) {
+    graphics_context_set_fill_color(ctx, text_layer->background);
+    graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+  }
+  // glyphs are not rasterized, the call is still counted
+  if(text_layer->text && text_layer->text[0]) {
+    count_draw(ctx);
+  }
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = host_alloc(sizeof(TextLayer), HOST_HEAP_OBJECT);
+  if(!text_layer) {
+    return NULL;
+  }
+  layer_init(&text_layer->layer, frame);
+  text_layer->layer.update_proc = text_layer_update_proc;
+  text_layer->background = GColorWhite;
+  text_layer->text_color = GColorBlack;
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  if(text_layer) {
+    layer_remove(&text_layer->layer);
+    host_free(text_layer);
+  }
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+  s_dirty = true;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+  text_layer->background = color;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+  text_layer->text_color = color;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+  text_layer->alignment = text_alignment;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  text_layer->font = font;
+}
+
+// bitmaps are centered in the layer, like the firmware's default alignment
+static void bitmap_layer_update_proc(Layer *layer, GContext *ctx) {
+  BitmapLayer *bitmap_layer = (BitmapLayer *)layer;
+  const GBitmap *bitmap = bitmap_layer->bitmap;
+  if(!bitmap) {
+    return;
+  }
+  GSize size = bitmap->bounds.size;
+  graphics_context_set_compositing_mode(ctx, bitmap_layer->compositing);
+  graphics_draw_bitmap_in_rect(ctx, bitmap, GRect((layer->bounds.size.w - size.w) / 2,
+                                                  (layer->bounds.size.h - size.h) / 2, size.w, size.h));
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+  BitmapLayer *bitmap_layer = host_alloc(sizeof(BitmapLayer), HOST_HEAP_OBJECT);
+  if(!bitmap_layer) {
+    return NULL;
+  }
+  layer_init(&bitmap_layer->layer, frame);
+  bitmap_layer->layer.update_proc = bitmap_layer_update_proc;
+  return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+  if(bitmap_layer) {
+    layer_remove(&bitmap_layer->layer);
+    host_free(bitmap_layer);
+  }
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+  return (Layer *)&bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+  bitmap_layer->bitmap = bitmap;
+  s_dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+  bitmap_layer->compositing = mode;
+}
+
+/////////////////////////////////////////////
+// rendering, any dirty layer redraws the  //
+// whole window like the firmware does     //
+/////////////////////////////////////////////
+static void render_layer(Layer *layer, GPoint origin, GRect clip) {
+  if(layer->hidden) {
+    return;
+  }
+  GPoint position = GPoint(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y);
+  GRect layer_clip = grect_intersect(clip, GRect(position.x, position.y, layer->frame.size.w, layer->frame.size.h));
+  if(layer->update_proc) {
+    context_reset(&s_ctx);
+    s_ctx.offset = position;
+    s_ctx.clip = layer_clip;
+    s_ctx.layer = layer;
+    layer->counters.renders++;
+    layer->update_proc(layer, &s_ctx);
+    s_ctx.layer = NULL;
+  }
+  for(Layer *child=layer->children; child; child=child->next) {
+    render_layer(child, position, layer_clip);
+  }
+}
+
+bool host_render() {
+  if(!s_dirty || !s_window || !s_window->loaded) {
+    return false;
+  }
+  s_dirty = false;
+  memset(s_frame_buffer, s_window->background == GColorBlack ? 0x00 : 0xFF, sizeof(s_frame_buffer));
+  render_layer(&s_window->root, GPointZero, GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  s_events.frames++;
+  return true;
+}
+
+static int collect_counters(Layer *layer, HostLayerCounters *counters, int count, int max) {
+  if(count < max) {
+    counters[count] = layer->counters;
+    if(!counters[count].name) {
+      counters[count].name = "?";
+    }
+  }
+  count++;
+  for(Layer *child=layer->children; child; child=child->next) {
+    count = collect_counters(child, counters, count, max);
+  }
+  return count;
+}
+
+int host_layer_counters(HostLayerCounters *counters, int max) {
+  if(!s_window) {
+    return 0;
+  }
+  // the root layer has no update proc, start at its children
+  int count = 0;
+  for(Layer *child=s_window->root.children; child; child=child->next) {
+    count = collect_counters(child, counters, count, max);
+  }
+  return MIN(count, max);
+}
+
+const HostLayerCounters *host_layer_get_counters(const Layer *layer) {
+  return &layer->counters;
+}
+
+static void reset_counters(Layer *layer) {
+  const char *name = layer->counters.name;
+  memset(&layer->counters, 0, sizeof(layer->counters));
+  layer->counters.name = name;
+  for(Layer *child=layer->children; child; child=child->next) {
+    reset_counters(child);
+  }
+}
+
+void host_reset_counters() {
+  if(s_window) {
+    reset_counters(&s_window->root);
+  }
+  s_trig_outside = 0;
+  memset(&s_events, 0, sizeof(s_events));
+}
+
+// every callback into the app is followed by a frame if anything changed
+static void dispatched(uint32_t *counter) {
+  (*counter)++;
+  host_render();
+}
+
+/////////////////////////////////////////////
+// windows                                 //
+/////////////////////////////////////////////
+Window *window_create(void) {
+  Window *window = host_alloc(sizeof(Window), HOST_HEAP_OBJECT);
+  if(!window) {
+    return NULL;
+  }
+  layer_init(&window->root, GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  window->background = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if(!window) {
+    return;
+  }
+  if(window == s_window) {
+    window_stack_pop(false);
+  }
+  host_free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background = background_color;
+  s_dirty = true;
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+  window->click_config = click_config_provider;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  s_window = window;
+  if(!window->loaded) {
+    window->loaded = true;
+    if(window->handlers.load) {
+      window->handlers.load(window);
+    }
+  }
+  if(window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+  memset(s_single_click, 0, sizeof(s_single_click));
+  memset(s_long_click, 0, sizeof(s_long_click));
+  if(window->click_config) {
+    window->click_config(window);
+  }
+  s_dirty = true;
+}
+
+Window *window_stack_pop(bool animated) {
+  Window *window = s_window;
+  if(!window) {
+    return NULL;
+  }
+  if(window->handlers.disappear) {
+    window->handlers.disappear(window);
+  }
+  if(window->loaded) {
+    window->loaded = false;
+    if(window->handlers.unload) {
+      window->handlers.unload(window);
+    }
+  }
+  s_window = NULL;
+  return window;
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  s_single_click[button_id] = handler;
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler,
+                                 ClickHandler up_handler) {
+  s_long_click[button_id] = down_handler;
+}
+
+void host_click(ButtonId button, bool long_press) {
+  ClickHandler handler = long_press ? s_long_click[button] : s_single_click[button];
+  if(handler) {
+    handler(NULL, s_window);
+    dispatched(&s_events.clicks);
+  }
+}
+
+/////////////////////////////////////////////
+// timers and ticks                        //
+/////////////////////////////////////////////
+static void timer_insert(AppTimer *timer) {
+  AppTimer **link = &s_timers;
+  while(*link && (*link)->due <= timer->due) {
+    link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+}
+
+static bool timer_unlink(AppTimer *timer) {
+  for(AppTimer **link=&s_timers; *link; link=&(*link)->next) {
+    if(*link == timer) {
+      *link = timer->next;
+      return true;
+    }
+  }
+  return false;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  AppTimer *timer = host_alloc(sizeof(AppTimer), HOST_HEAP_TIMER);
+  if(!timer) {
+    return NULL;
+  }
+  timer->due = s_now_ms + timeout_ms;
+  timer->callback = callback;
+  timer->data = callback_data;
+  timer_insert(timer);
+  return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if(!timer_handle || !timer_unlink(timer_handle)) {
+    return false;
+  }
+  timer_handle->due = s_now_ms + new_timeout_ms;
+  timer_insert(timer_handle);
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if(timer_handle && timer_unlink(timer_handle)) {
+    host_free(timer_handle);
+  }
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_units = tick_units;
+  s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_handler = NULL;
+}
+
+static TimeUnits units_changed(time_t before, time_t after) {
+  struct tm a = *localtime(&before);
+  struct tm b = *localtime(&after);
+  TimeUnits units = 0;
+  units |= a.tm_sec != b.tm_sec ? SECOND_UNIT : 0;
+  units |= a.tm_min != b.tm_min ? MINUTE_UNIT : 0;
+  units |= a.tm_hour != b.tm_hour ? HOUR_UNIT : 0;
+  units |= a.tm_mday != b.tm_mday ? DAY_UNIT : 0;
+  units |= a.tm_mon != b.tm_mon ? MONTH_UNIT : 0;
+  units |= a.tm_year != b.tm_year ? YEAR_UNIT : 0;
+  return units;
+}
+
+static void outbox_finish(bool ack);
+
+void host_advance_ms(uint64_t ms) {
+  uint64_t target = s_now_ms + ms;
+  for(;;) {
+    uint64_t next_second = (s_now_ms / 1000 + 1) * 1000;
+    uint64_t next = next_second;
+    if(s_timers && s_timers->due < next) {
+      next = s_timers->due;
+    }
+    if(s_outbox_state == OUTBOX_IN_FLIGHT && s_outbox_due && s_outbox_due < next) {
+      next = s_outbox_due;
+    }
+    if(next > target) {
+      s_now_ms = target;
+      return;
+    }
+    uint64_t before = s_now_ms;
+    s_now_ms = MAX(next, s_now_ms);
+
+    if(s_outbox_state == OUTBOX_IN_FLIGHT && s_outbox_due && s_outbox_due <= s_now_ms) {
+      outbox_finish(s_outbox_mode == HOST_OUTBOX_ACK);
+    } else if(s_timers && s_timers->due <= s_now_ms) {
+      AppTimer *timer = s_timers;
+      s_timers = timer->next;
+      AppTimerCallback callback = timer->callback;
+      void *data = timer->data;
+      host_free(timer);
+      callback(data);
+      dispatched(&s_events.timers);
+    } else if(s_now_ms == next_second && s_tick_handler) {
+      TimeUnits units = units_changed(before / 1000, s_now_ms / 1000);
+      if(units & s_tick_units) {
+        time_t now = host_now();
+        struct tm tick_time = *localtime(&now);
+        s_tick_handler(&tick_time, units);
+        dispatched(&s_events.ticks);
+      }
+    }
+  }
+}
+
+void host_advance_to(time_t t) {
+  if((uint64_t)t * 1000 > s_now_ms) {
+    host_advance_ms((uint64_t)t * 1000 - s_now_ms);
+  }
+}
+
+/////////////////////////////////////////////
+// device services                         //
+/////////////////////////////////////////////
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+  s_tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+  s_tap_handler = NULL;
+}
+
+void host_tap() {
+  if(s_tap_handler) {
+    s_tap_handler(ACCEL_AXIS_X, 1);
+    dispatched(&s_events.taps);
+  }
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+  s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+  s_battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery;
+}
+
+void host_battery(uint8_t percent, bool charging) {
+  s_battery = (BatteryChargeState) {
+    .charge_percent = percent,
+    .is_charging = charging,
+    .is_plugged = charging
+  };
+  if(s_battery_handler) {
+    s_battery_handler(s_battery);
+    dispatched(&s_events.battery);
+  }
+}
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+  s_connection_handler = conn_handlers.pebble_app_connection_handler;
+}
+
+void connection_service_unsubscribe(void) {
+  s_connection_handler = NULL;
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  return s_connected;
+}
+
+void host_connection(bool connected) {
+  s_connected = connected;
+  if(s_connection_handler) {
+    s_connection_handler(connected);
+    dispatched(&s_events.connection);
+  }
+}
+
+void vibes_double_pulse(void) {
+  s_events.vibes++;
+}
+
+void vibes_short_pulse(void) {
+  s_events.vibes++;
+}
+
+/////////////////////////////////////////////
+// health, one step count per minute,      //
+// minutes are recorded once they are over //
+/////////////////////////////////////////////
+static uint8_t minute_steps(int64_t minute) {
+  int64_t index = minute - s_steps_base / SECONDS_PER_MINUTE;
+  if(index < 0 || index >= (int64_t)sizeof(s_steps)) {
+    return 0;
+  }
+  return s_steps[index];
+}
+
+void host_health_walk(time_t start, time_t end, uint8_t steps_per_minute) {
+  for(time_t t=start; t<end; t+=SECONDS_PER_MINUTE) {
+    int64_t index = (t - s_steps_base) / SECONDS_PER_MINUTE;
+    if(index >= 0 && index < (int64_t)sizeof(s_steps)) {
+      s_steps[index] = steps_per_minute;
+    }
+  }
+}
+
+void host_health_set_sleeping(bool sleeping) {
+  s_sleeping = sleeping;
+}
+
+bool health_service_events_subscribe(HealthEventHandler handler, void *context) {
+  s_health_handler = handler;
+  s_health_context = context;
+  return true;
+}
+
+bool health_service_events_unsubscribe(void) {
+  s_health_handler = NULL;
+  return true;
+}
+
+void host_health_event(HealthEventType event) {
+  if(s_health_handler) {
+    s_health_handler(event, s_health_context);
+    dispatched(&s_events.health);
+  }
+}
+
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end) {
+  s_health_reads.sums++;
+  int64_t recorded = host_now() / SECONDS_PER_MINUTE;
+  HealthValue total = 0;
+  for(int64_t minute=(time_start + SECONDS_PER_MINUTE - 1) / SECONDS_PER_MINUTE;
+      minute * SECONDS_PER_MINUTE < time_end && minute < recorded; minute++) {
+    total += minute_steps(minute);
+  }
+  return total;
+}
+
+HealthValue health_service_sum_today(HealthMetric metric) {
+  return health_service_sum(metric, time_start_of_today(), host_now());
+}
+
+HealthActivityMask health_service_peek_current_activities(void) {
+  return s_sleeping ? HealthActivitySleep : HealthActivityNone;
+}
+
+uint32_t health_service_get_minute_history(HealthMinuteData *minute_data, uint32_t max_records,
+                                           time_t *time_start, time_t *time_end) {
+  s_health_reads.minute_reads++;
+  int64_t first = *time_start / SECONDS_PER_MINUTE;
+  int64_t last = MIN((*time_end + SECONDS_PER_MINUTE - 1) / SECONDS_PER_MINUTE,
+                     (int64_t)host_now() / SECONDS_PER_MINUTE);
+  if(last <= first) {
+    return 0;
+  }
+  uint32_t count = MIN((uint32_t)(last - first), max_records);
+  for(uint32_t i=0; i<count; i++) {
+    minute_data[i] = (HealthMinuteData) { .steps = minute_steps(first + i) };
+  }
+  *time_start = first * SECONDS_PER_MINUTE;
+  *time_end = (first + count) * SECONDS_PER_MINUTE;
+  s_health_reads.minutes_read += count;
+  return count;
+}
+
+const HostHealthReads *host_health_reads() {
+  return &s_health_reads;
+}
+
+/////////////////////////////////////////////
+// storage                                 //
+/////////////////////////////////////////////
+static PersistEntry *persist_entry(uint32_t key, bool create) {
+  PersistEntry *free_entry = NULL;
+  for(int i=0; i<HOST_PERSIST_KEYS; i++) {
+    if(s_persist[i].slot && s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+    if(!free_entry && !s_persist[i].slot) {
+      free_entry = &s_persist[i];
+    }
+  }
+  if(!create || !free_entry) {
+    return NULL;
+  }
+  free_entry->slot = true;
+  free_entry->key = key;
+  return free_entry;
+}
+
+bool persist_exists(const uint32_t key) {
+  PersistEntry *entry = persist_entry(key, false);
+  return entry && entry->used;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  PersistEntry *entry = persist_entry(key, true);
+  if(!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->reads++;
+  if(!entry->used) {
+    return E_DOES_NOT_EXIST;
+  }
+  size_t size = MIN(buffer_size, entry->size);
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  PersistEntry *entry = persist_entry(key, true);
+  if(!entry) {
+    return 0;
+  }
+  size_t stored = MIN(size, (size_t)HOST_PERSIST_MAX);
+  memcpy(entry->data, data, stored);
+  entry->size = stored;
+  entry->used = true;
+  entry->writes++;
+  return stored;
+}
+
+int persist_delete(const uint32_t key) {
+  PersistEntry *entry = persist_entry(key, false);
+  if(!entry || !entry->used) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+  return 0;
+}
+
+uint32_t host_persist_writes(uint32_t key) {
+  PersistEntry *entry = persist_entry(key, false);
+  return entry ? entry->writes : 0;
+}
+
+uint32_t host_persist_reads(uint32_t key) {
+  PersistEntry *entry = persist_entry(key, false);
+  return entry ? entry->reads : 0;
+}
+
+/////////////////////////////////////////////
+// dictionaries, same layout as the SDK:   //
+// a count byte, then packed tuples        //
+/////////////////////////////////////////////
+static void dict_reset(DictionaryIterator *iter, uint32_t size) {
+  memset(iter, 0, sizeof(*iter));
+  iter->size = MIN(size, (uint32_t)HOST_DICT_MAX);
+  iter->used = 1;
+}
+
+static Tuple *dict_append(DictionaryIterator *iter, uint32_t key, TupleType type, uint16_t length) {
+  if(iter->used + HOST_TUPLE_HEADER + length > iter->size) {
+    return NULL;
+  }
+  Tuple *tuple = (Tuple *)&iter->buffer[iter->used];
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = length;
+  iter->used += HOST_TUPLE_HEADER + length;
+  iter->buffer[0]++;
+  return tuple;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  uint32_t offset = 1;
+  for(int i=0; i<iter->buffer[0]; i++) {
+    Tuple *tuple = (Tuple *)&iter->buffer[offset];
+    if(tuple->key == key) {
+      return tuple;
+    }
+    offset += HOST_TUPLE_HEADER + tuple->length;
+  }
+  return NULL;
+}
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+  uint32_t size = 1 + tuple_count * HOST_TUPLE_HEADER;
+  va_list sizes;
+  va_start(sizes, tuple_count);
+  for(int i=0; i<tuple_count; i++) {
+    size += va_arg(sizes, uint32_t);
+  }
+  va_end(sizes);
+  return size;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  Tuple *tuple = dict_append(iter, key, TUPLE_UINT, 1);
+  if(!tuple) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  tuple->value->uint8 = value;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  Tuple *tuple = dict_append(iter, key, TUPLE_INT, 4);
+  if(!tuple) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  tuple->value->int32 = value;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data,
+                                 const uint16_t size) {
+  Tuple *tuple = dict_append(iter, key, TUPLE_BYTE_ARRAY, size);
+  if(!tuple) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  memcpy(tuple->value->data, data, size);
+  return DICT_OK;
+}
+
+/////////////////////////////////////////////
+// app messages, one outbound message in   //
+// flight at a time like the firmware      //
+/////////////////////////////////////////////
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  s_inbox_size = size_inbound;
+  s_outbox_size = size_outbound;
+  return APP_MSG_OK;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived previous = s_inbox_received;
+  s_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped previous = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent previous = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed previous = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return previous;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if(!s_outbox_size) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  if(s_outbox_state != OUTBOX_IDLE) {
+    return APP_MSG_BUSY;
+  }
+  dict_reset(&s_outbox, s_outbox_size);
+  s_outbox_state = OUTBOX_BEGUN;
+  *iterator = &s_outbox;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if(s_outbox_state != OUTBOX_BEGUN) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  s_outbox_log[s_outbox_count % HOST_OUTBOX_LOG] = s_outbox;
+  s_outbox_count++;
+  s_outbox_state = OUTBOX_IN_FLIGHT;
+  s_outbox_due = s_outbox_mode == HOST_OUTBOX_HOLD ? 0 : s_now_ms + HOST_OUTBOX_LATENCY_MS;
+  return APP_MSG_OK;
+}
+
+static void outbox_finish(bool ack) {
+  s_outbox_state = OUTBOX_IDLE;
+  s_outbox_due = 0;
+  if(ack && s_connected) {
+    if(s_outbox_sent) {
+      s_outbox_sent(&s_outbox, NULL);
+    }
+  } else if(s_outbox_failed) {
+    s_outbox_failed(&s_outbox, s_connected ? APP_MSG_SEND_TIMEOUT : APP_MSG_NOT_CONNECTED, NULL);
+  }
+  dispatched(&s_events.outbox);
+}
+
+void host_outbox_mode(HostOutboxMode mode) {
+  s_outbox_mode = mode;
+}
+
+void host_outbox_complete(bool ack) {
+  if(s_outbox_state == OUTBOX_IN_FLIGHT) {
+    outbox_finish(ack);
+  }
+}
+
+bool host_outbox_in_flight() {
+  return s_outbox_state == OUTBOX_IN_FLIGHT;
+}
+
+uint32_t host_outbox_count() {
+  return s_outbox_count;
+}
+
+const Tuple *host_outbox_find(uint32_t index, uint32_t key) {
+  if(index >= s_outbox_count || index + HOST_OUTBOX_LOG < s_outbox_count) {
+    return NULL;
+  }
+  return dict_find(&s_outbox_log[index % HOST_OUTBOX_LOG], key);
+}
+
+DictionaryIterator *host_inbox_begin() {
+  dict_reset(&s_inbox, HOST_DICT_MAX);
+  return &s_inbox;
+}
+
+void host_inbox_deliver() {
+  if(s_inbox.used > s_inbox_size) {
+    if(s_inbox_dropped) {
+      s_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+    }
+  } else if(s_inbox_received) {
+    s_inbox_received(&s_inbox, NULL);
+  }
+  dispatched(&s_events.inbox);
+}
+
+/////////////////////////////////////////////
+// worker                                  //
+/////////////////////////////////////////////
+AppWorkerResult app_worker_launch(void) {
+  return s_worker_result;
+}
+
+bool app_worker_message_subscribe(AppWorkerMessageHandler handler) {
+  s_worker_handler = handler;
+  return true;
+}
+
+bool app_worker_message_unsubscribe(void) {
+  s_worker_handler = NULL;
+  return true;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data) {
+  s_worker_last = *data;
+  s_worker_last_type = type;
+  s_worker_sent++;
+}
+
+void host_worker_launch_result(AppWorkerResult result) {
+  s_worker_result = result;
+}
+
+void host_worker_message(uint16_t type, const AppWorkerMessage *message) {
+  if(s_worker_handler) {
+    AppWorkerMessage copy = *message;
+    s_worker_handler(type, &copy);
+    dispatched(&s_events.worker);
+  }
+}
+
+uint32_t host_worker_sent() {
+  return s_worker_sent;
+}
+
+const AppWorkerMessage *host_worker_last() {
+  return &s_worker_last;
+}
+
+uint8_t host_worker_last_type() {
+  return s_worker_last_type;
+}
+
+/////////////////////////////////////////////
+// app                                     //
+/////////////////////////////////////////////
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  if(!getenv("HOST_LOG")) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%d] %s:%d ", log_level, src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+// the tests drive events themselves
+void app_event_loop(void) {
+}
+
+void worker_event_loop(void) {
+}
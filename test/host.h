@@ -0,0 +1,182 @@
+#pragma once
+#include <pebble.h>
+
+///////////////////////////////////////////////////
+// simulated diorite for host tests              //
+// a 144x168 1-bit screen, a simulated clock,    //
+// heap, storage, health and phone link, driven  //
+// from the test instead of real hardware        //
+///////////////////////////////////////////////////
+#define HOST_SCREEN_WIDTH 144
+#define HOST_SCREEN_HEIGHT 168
+// frame buffer rows are word aligned, LSB is the leftmost pixel, 1 is white
+#define HOST_ROW_BYTES 20
+
+// starts the clock at start, UTC, once per process, tests fork to
+// get a fresh watch per scenario
+void host_init(time_t start);
+
+//////////////////////
+// clock and events //
+//////////////////////
+time_t host_now();
+uint64_t host_now_ms();
+
+// moves the clock forward, firing ticks, timers and message
+// callbacks in time order, and renders after each like the firmware
+void host_advance_ms(uint64_t ms);
+void host_advance_to(time_t t);
+
+// every callback into the app, by source
+typedef struct {
+  uint32_t ticks;
+  uint32_t timers;
+  uint32_t health;
+  uint32_t battery;
+  uint32_t connection;
+  uint32_t taps;
+  uint32_t clicks;
+  uint32_t inbox;
+  uint32_t outbox;
+  uint32_t worker;
+  uint32_t vibes;
+  uint32_t frames;
+} HostEvents;
+
+const HostEvents *host_events();
+
+//////////////////////
+// screen           //
+//////////////////////
+// renders the window if anything is dirty, true if a frame was drawn
+bool host_render();
+// white is true
+bool host_pixel(int x, int y);
+const uint8_t *host_frame_buffer();
+
+// per layer counters, marks are layer_mark_dirty calls, draws are
+// graphics calls, pixels are pixel writes, or the pixels changed between
+// capturing and releasing the frame buffer, trig is sin/cos/atan2
+// lookups made while the layer was drawing
+typedef struct {
+  const char *name;
+  uint32_t marks;
+  uint32_t renders;
+  uint32_t draws;
+  uint32_t pixels;
+  uint32_t trig;
+} HostLayerCounters;
+
+void host_name_layer(Layer *layer, const char *name);
+// fills counters for every layer in the window in draw order, returns count
+int host_layer_counters(HostLayerCounters *counters, int max);
+const HostLayerCounters *host_layer_get_counters(const Layer *layer);
+void host_reset_counters();
+// trig lookups made outside update procs
+uint32_t host_trig_outside_render();
+
+//////////////////////
+// heap             //
+//////////////////////
+typedef enum {
+  HOST_HEAP_OBJECT,   // layers, bitmaps, windows
+  HOST_HEAP_TIMER,    // app timers, live until they fire or are cancelled
+  HOST_HEAP_TAG_COUNT
+} HostHeapTag;
+
+size_t host_heap_used(HostHeapTag tag);
+size_t host_heap_peak();
+void host_heap_reset_peak();
+// allocations made since host_init
+uint32_t host_heap_allocations();
+// the allocation with this index (counted from host_init) fails, -1 disables
+void host_heap_fail_at(int32_t index);
+
+//////////////////////
+// storage          //
+//////////////////////
+uint32_t host_persist_writes(uint32_t key);
+uint32_t host_persist_reads(uint32_t key);
+
+//////////////////////
+// health           //
+//////////////////////
+// steps recorded for every minute in [start, end)
+void host_health_walk(time_t start, time_t end, uint8_t steps_per_minute);
+void host_health_set_sleeping(bool sleeping);
+void host_health_event(HealthEventType event);
+
+typedef struct {
+  uint32_t sums;            // health_service_sum and sum_today calls
+  uint32_t minute_reads;    // minute history calls
+  uint32_t minutes_read;    // minute records returned
+} HostHealthReads;
+
+const HostHealthReads *host_health_reads();
+
+//////////////////////
+// device           //
+//////////////////////
+void host_battery(uint8_t percent, bool charging);
+void host_connection(bool connected);
+void host_tap();
+void host_click(ButtonId button, bool long_press);
+
+//////////////////////
+// phone link       //
+//////////////////////
+typedef enum {
+  HOST_OUTBOX_ACK,      // the phone acks every message
+  HOST_OUTBOX_NACK,     // every message fails
+  HOST_OUTBOX_HOLD      // messages stay in flight until host_outbox_complete
+} HostOutboxMode;
+
+// time the phone takes to ack or nack a message
+#define HOST_OUTBOX_LATENCY_MS 200
+
+void host_outbox_mode(HostOutboxMode mode);
+void host_outbox_complete(bool ack);
+bool host_outbox_in_flight();
+// messages handed to app_message_outbox_send
+uint32_t host_outbox_count();
+// key in the outbox message with this index, NULL if absent
+const Tuple *host_outbox_find(uint32_t index, uint32_t key);
+
+// builds an inbound message with the dict_write_* calls, then delivers it
+DictionaryIterator *host_inbox_begin();
+void host_inbox_deliver();
+
+//////////////////////
+// worker           //
+//////////////////////
+void host_worker_launch_result(AppWorkerResult result);
+// delivers a message to the face's worker subscription
+void host_worker_message(uint16_t type, const AppWorkerMessage *message);
+uint32_t host_worker_sent();
+const AppWorkerMessage *host_worker_last();
+uint8_t host_worker_last_type();
+
+//////////////////////
+// images           //
+//////////////////////
+// 1-bit grayscale PNG of the frame buffer, stored deflate blocks so the
+// bytes only depend on the pixels
+bool host_png_write(const char *path);
+// pixels differing from a PNG written by host_png_write, -1 if unreadable
+int host_png_compare(const char *path);
+
+//////////////////////
+// resources        //
+//////////////////////
+// bitmaps decoded from package.json media by test/gen_resources.py,
+// 1 is white in data and opaque in alpha, alpha is NULL when opaque
+typedef struct {
+  uint32_t id;
+  int16_t width;
+  int16_t height;
+  uint16_t row_bytes;
+  const uint8_t *data;
+  const uint8_t *alpha;
+} HostResource;
+
+const HostResource *host_resource(uint32_t id);
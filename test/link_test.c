@@ -0,0 +1,85 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// feeds flap sequences to the face's connection //
+// handler and counts vibrations, Bluetooth icon //
+// changes and what the weather scheduler sees   //
+///////////////////////////////////////////////////
+#define MAX_STEPS 64
+
+typedef struct {
+  bool connected;
+  uint32_t hold_ms;
+} Flap;
+
+typedef struct {
+  const char *name;
+  uint32_t grace_seconds;   // sent from the phone first, 0 keeps the default
+  Flap steps[MAX_STEPS];
+  int repeat;               // the steps play this many times
+  uint32_t vibes;
+  uint32_t icon_changes;
+  bool usable;              // what the scheduler is told at the end
+} Sequence;
+
+static const Sequence SEQUENCES[] = {
+  { "short drop", 0, { { false, 10000 }, { true, 60000 } }, 1, 0, 0, true },
+  { "flap storm", 0, { { false, 2000 }, { true, 2000 } }, 40, 0, 0, true },
+  { "sustained drop", 0, { { false, 60000 } }, 1, 1, 1, false },
+  { "drop and return", 0, { { false, 60000 }, { true, 60000 } }, 1, 1, 2, true },
+  { "return too short", 0, { { false, 60000 }, { true, 3000 }, { false, 60000 } }, 1, 1, 1, false },
+  // a drop every 50s alerts once per LINK_ALERT_MIN_GAP, not once per drop
+  { "reconnect storm", 0, { { false, 40000 }, { true, 10000 } }, 12, 2, 24, true },
+  { "longer grace", 120, { { false, 60000 }, { true, 60000 } }, 1, 0, 0, true },
+};
+
+static bool icon_hidden() {
+  return layer_get_hidden(bitmap_layer_get_layer(s_bluetooth_bitmap_layer));
+}
+
+static int sequence_run(const void *arg) {
+  const Sequence *sequence = arg;
+  host_init(FACE_AT(12, 0, 0));
+  init();
+  face_name_layers();
+  host_render();
+  if(sequence->grace_seconds) {
+    dict_write_int32(host_inbox_begin(), KEY_DISCONNECT_GRACE, sequence->grace_seconds);
+    host_inbox_deliver();
+  }
+
+  uint32_t vibes = host_events()->vibes;
+  uint32_t icon_changes = 0;
+  bool hidden = icon_hidden();
+  for(int r=0; r<sequence->repeat; r++) {
+    for(int i=0; i<MAX_STEPS && sequence->steps[i].hold_ms; i++) {
+      host_connection(sequence->steps[i].connected);
+      // sample the icon every second so every change is seen
+      for(uint32_t held=0; held<sequence->steps[i].hold_ms; held+=1000) {
+        host_advance_ms(1000);
+        if(icon_hidden() != hidden) {
+          hidden = !hidden;
+          icon_changes++;
+        }
+      }
+    }
+  }
+  vibes = host_events()->vibes - vibes;
+  bool usable = scheduler_get_stats()->connected;
+
+  const LinkStats *stats = link_get_stats();
+  bool ok = vibes == sequence->vibes && icon_changes == sequence->icon_changes && usable == sequence->usable;
+  printf("%s %-16s vibes %u/%u, icon changes %u/%u, usable %d/%d, raw %u, absorbed %u, alerts %u\n",
+         ok ? "ok  " : "FAIL", sequence->name, vibes, sequence->vibes, icon_changes, sequence->icon_changes, usable,
+         sequence->usable, stats->raw_changes, stats->absorbed, stats->alerts);
+  return ok ? 0 : 1;
+}
+
+int main() {
+  int failures = 0;
+  for(size_t i=0; i<sizeof(SEQUENCES)/sizeof(SEQUENCES[0]); i++) {
+    failures += face_run_isolated(sequence_run, &SEQUENCES[i]) != 0;
+  }
+  printf("link: %d failed\n", failures);
+  return failures ? 1 : 0;
+}
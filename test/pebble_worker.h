@@ -0,0 +1,7 @@
+#pragma once
+
+///////////////////////////////////////////////////
+// the worker SDK is a subset of the app SDK,    //
+// test/pebble.h covers both                     //
+///////////////////////////////////////////////////
+#include "pebble.h"
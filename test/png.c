@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include "host.h"
+
+///////////////////////////////////////////////////
+// minimal PNG for the golden images             //
+// 1-bit grayscale, one stored deflate block, no //
+// compression so the bytes only depend on the   //
+// pixels and no zlib is needed                  //
+///////////////////////////////////////////////////
+#define PNG_ROW_BYTES ((HOST_SCREEN_WIDTH + 7) / 8)
+#define PNG_RAW_SIZE (HOST_SCREEN_HEIGHT * (1 + PNG_ROW_BYTES))
+
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length) {
+  crc = ~crc;
+  for(size_t i=0; i<length; i++) {
+    crc ^= data[i];
+    for(int k=0; k<8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t length) {
+  uint32_t a = 1, b = 0;
+  for(size_t i=0; i<length; i++) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+  out[0] = value >> 24;
+  out[1] = value >> 16;
+  out[2] = value >> 8;
+  out[3] = value;
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+  return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+static void write_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t length) {
+  uint8_t header[8];
+  put_u32(header, length);
+  memcpy(header + 4, type, 4);
+  uint32_t crc = crc32_update(0, header + 4, 4);
+  crc = crc32_update(crc, data, length);
+  uint8_t trailer[4];
+  put_u32(trailer, crc);
+  fwrite(header, 1, 8, file);
+  fwrite(data, 1, length, file);
+  fwrite(trailer, 1, 4, file);
+}
+
+// frame buffer rows as PNG scanlines, filter 0, MSB is leftmost
+static void frame_to_raw(uint8_t *raw) {
+  memset(raw, 0, PNG_RAW_SIZE);
+  for(int y=0; y<HOST_SCREEN_HEIGHT; y++) {
+    uint8_t *row = raw + y * (1 + PNG_ROW_BYTES) + 1;
+    for(int x=0; x<HOST_SCREEN_WIDTH; x++) {
+      if(host_pixel(x, y)) {
+        row[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+  }
+}
+
+bool host_png_write(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if(!file) {
+    return false;
+  }
+  uint8_t ihdr[13] = { 0 };
+  put_u32(ihdr, HOST_SCREEN_WIDTH);
+  put_u32(ihdr + 4, HOST_SCREEN_HEIGHT);
+  ihdr[8] = 1;    // bit depth
+  ihdr[9] = 0;    // grayscale
+
+  // zlib header, one final stored block, adler32
+  static uint8_t idat[2 + 5 + PNG_RAW_SIZE + 4];
+  uint8_t *raw = idat + 7;
+  frame_to_raw(raw);
+  idat[0] = 0x78;
+  idat[1] = 0x01;
+  idat[2] = 0x01;
+  idat[3] = PNG_RAW_SIZE & 0xFF;
+  idat[4] = PNG_RAW_SIZE >> 8;
+  idat[5] = ~PNG_RAW_SIZE & 0xFF;
+  idat[6] = (~PNG_RAW_SIZE >> 8) & 0xFF;
+  put_u32(idat + 7 + PNG_RAW_SIZE, adler32(raw, PNG_RAW_SIZE));
+
+  fwrite(PNG_SIGNATURE, 1, sizeof(PNG_SIGNATURE), file);
+  write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+  write_chunk(file, "IDAT", idat, sizeof(idat));
+  write_chunk(file, "IEND", NULL, 0);
+  return fclose(file) == 0;
+}
+
+///////////////////////////////////////////////////
+// reads back what host_png_write produced,      //
+// compressed PNGs from other tools are refused  //
+///////////////////////////////////////////////////
+static bool png_read_raw(const char *path, uint8_t *raw) {
+  FILE *file = fopen(path, "rb");
+  if(!file) {
+    return false;
+  }
+  static uint8_t buffer[16 * 1024];
+  size_t size = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+  if(size < sizeof(PNG_SIGNATURE) || memcmp(buffer, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) {
+    return false;
+  }
+  static uint8_t zlib[sizeof(buffer)];
+  size_t zlib_size = 0;
+  bool header_ok = false;
+  for(size_t offset=sizeof(PNG_SIGNATURE); offset + 12 <= size;) {
+    uint32_t length = get_u32(buffer + offset);
+    const uint8_t *type = buffer + offset + 4;
+    const uint8_t *data = buffer + offset + 8;
+    if(offset + 12 + length > size) {
+      return false;
+    }
+    if(!memcmp(type, "IHDR", 4)) {
+      header_ok = length == 13 && get_u32(data) == HOST_SCREEN_WIDTH && get_u32(data + 4) == HOST_SCREEN_HEIGHT &&
+                  data[8] == 1 && data[9] == 0 && data[12] == 0;
+    } else if(!memcmp(type, "IDAT", 4)) {
+      memcpy(zlib + zlib_size, data, length);
+      zlib_size += length;
+    }
+    offset += 12 + length;
+  }
+  if(!header_ok || zlib_size < 2) {
+    return false;
+  }
+  // stored blocks only
+  size_t raw_size = 0;
+  size_t offset = 2;
+  bool final = false;
+  while(!final && offset + 5 <= zlib_size) {
+    uint8_t block = zlib[offset];
+    final = block & 1;
+    uint16_t length = zlib[offset + 1] | (zlib[offset + 2] << 8);
+    if((block >> 1) & 3 || raw_size + length > PNG_RAW_SIZE || offset + 5 + length > zlib_size) {
+      return false;
+    }
+    memcpy(raw + raw_size, zlib + offset + 5, length);
+    raw_size += length;
+    offset += 5 + length;
+  }
+  return final && raw_size == PNG_RAW_SIZE;
+}
+
+int host_png_compare(const char *path) {
+  static uint8_t expected[PNG_RAW_SIZE], actual[PNG_RAW_SIZE];
+  if(!png_read_raw(path, expected)) {
+    return -1;
+  }
+  frame_to_raw(actual);
+  int differences = 0;
+  for(int y=0; y<HOST_SCREEN_HEIGHT; y++) {
+    const uint8_t *a = expected + y * (1 + PNG_ROW_BYTES);
+    const uint8_t *b = actual + y * (1 + PNG_ROW_BYTES);
+    if(a[0] != 0) {
+      return -1;
+    }
+    for(int x=0; x<HOST_SCREEN_WIDTH; x++) {
+      if((a[1 + (x >> 3)] ^ b[1 + (x >> 3)]) & (0x80 >> (x & 7))) {
+        differences++;
+      }
+    }
+  }
+  return differences;
+}
@@ -0,0 +1,96 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// the profile dump shares the outbox with the   //
+// weather request, it must wait its turn and    //
+// never count against the weather scheduler     //
+///////////////////////////////////////////////////
+static int s_failures;
+
+static void expect(bool condition, const char *name, const char *what) {
+  if(!condition) {
+    printf("FAIL %s: %s\n", name, what);
+    s_failures++;
+  }
+}
+
+static void launch(bool weather_fresh, HostOutboxMode mode) {
+  host_init(FACE_AT(9, 0, 0));
+  host_outbox_mode(mode);
+  init();
+  host_render();
+  if(weather_fresh) {
+    face_send_weather(WEATHER_CLEAR_DAY, 12, host_now());
+  }
+}
+
+// what app.js sends on launch with profileOnReady set
+static void send_ready_with_profile() {
+  DictionaryIterator *iterator = host_inbox_begin();
+  dict_write_int32(iterator, KEY_JS_READY, 1);
+  dict_write_int32(iterator, KEY_PROFILE_REQUEST, 1);
+  host_inbox_deliver();
+}
+
+#if PROFILE_ENABLED
+static int run_weather_due(const void *arg) {
+  const char *name = "weather due";
+  launch(false, HOST_OUTBOX_ACK);
+  uint32_t first = host_outbox_count();
+  send_ready_with_profile();
+  host_advance_ms(2 * HOST_OUTBOX_LATENCY_MS);
+  const SchedulerStats *scheduler = scheduler_get_stats();
+  expect(host_outbox_count() == first + 2, name, "expected a weather request and a dump");
+  expect(host_outbox_find(first, KEY_REQUEST_WEATHER) != NULL, name, "weather request did not go first");
+  expect(host_outbox_find(first + 1, KEY_PROFILE) != NULL, name, "dump did not follow the weather request");
+  expect(scheduler->failures == 0, name, "weather request failed");
+  expect(scheduler->acks == 1, name, "the dump's ack counted as a weather ack");
+  return s_failures ? 1 : 0;
+}
+
+static int run_weather_fresh(const void *arg) {
+  const char *name = "weather fresh";
+  launch(true, HOST_OUTBOX_ACK);
+  uint32_t first = host_outbox_count();
+  send_ready_with_profile();
+  host_advance_ms(HOST_OUTBOX_LATENCY_MS);
+  expect(host_outbox_count() == first + 1, name, "expected only the dump");
+  expect(host_outbox_find(first, KEY_PROFILE) != NULL, name, "dump not sent right away");
+  return s_failures ? 1 : 0;
+}
+#else
+// a RELEASE build has no dump, the request is ignored
+static int run_release(const void *arg) {
+  const char *name = "release";
+  launch(false, HOST_OUTBOX_ACK);
+  uint32_t first = host_outbox_count();
+  send_ready_with_profile();
+  host_advance_ms(2 * HOST_OUTBOX_LATENCY_MS);
+  expect(host_outbox_count() == first + 1, name, "expected only the weather request");
+  expect(host_outbox_find(first, KEY_REQUEST_WEATHER) != NULL, name, "weather request not sent");
+  return s_failures ? 1 : 0;
+}
+#endif
+
+static int run_dump_nacked(const void *arg) {
+  const char *name = "dump nacked";
+  launch(true, HOST_OUTBOX_NACK);
+  send_ready_with_profile();
+  host_advance_ms(HOST_OUTBOX_LATENCY_MS);
+  const SchedulerStats *scheduler = scheduler_get_stats();
+  expect(scheduler->failures == 0 && scheduler->backoff_level == 0, name, "a lost dump backed off the scheduler");
+  return s_failures ? 1 : 0;
+}
+
+int main() {
+  int failures = 0;
+#if PROFILE_ENABLED
+  failures += face_run_isolated(run_weather_due, NULL) != 0;
+  failures += face_run_isolated(run_weather_fresh, NULL) != 0;
+#else
+  failures += face_run_isolated(run_release, NULL) != 0;
+#endif
+  failures += face_run_isolated(run_dump_nacked, NULL) != 0;
+  printf("profile: %d failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// renders the face for a set of times, battery  //
+// levels, step counts and weather states and    //
+// compares each frame with test/golden/*.png,   //
+// `render_test --golden` rewrites the goldens   //
+///////////////////////////////////////////////////
+#define GOLDEN_DIR "golden"
+// where failed frames are written, the Makefile passes its BUILD
+#ifndef ACTUAL_DIR
+#define ACTUAL_DIR "build"
+#endif
+#define NO_WEATHER 0xFE
+
+typedef struct {
+  const char *name;
+  time_t time;
+  uint8_t battery;
+  bool charging;
+  bool connected;
+  int32_t goal;
+  uint8_t steps_per_minute;     // walked from 07:00 until two hours before time
+  uint8_t condition;            // NO_WEATHER keeps the launch placeholder
+  int16_t temperature;
+  bool tap;                     // wrist flick, shows the seconds hand
+  bool sleeping;
+} Scenario;
+
+static const Scenario SCENARIOS[] = {
+  // times
+  { "time_1010", FACE_AT(10, 10, 0), 80, false, true, 8000, 20, WEATHER_CLEAR_DAY, 18 },
+  { "time_0000", FACE_AT(0, 0, 0), 80, false, true, 8000, 0, WEATHER_CLEAR_NIGHT, 5 },
+  { "time_0347", FACE_AT(3, 47, 0), 80, false, true, 8000, 0, WEATHER_CLOUDY, 4 },
+  { "time_1559", FACE_AT(15, 59, 0), 80, false, true, 8000, 20, WEATHER_PARTLY_CLOUDY_DAY, 21 },
+  { "time_seconds", FACE_AT(10, 10, 23), 80, false, true, 8000, 20, WEATHER_CLEAR_DAY, 18, true },
+  // battery levels
+  { "battery_100_charging", FACE_AT(12, 30, 0), 100, true, true, 8000, 20, WEATHER_CLEAR_DAY, 18 },
+  { "battery_045", FACE_AT(12, 30, 0), 45, false, true, 8000, 20, WEATHER_CLEAR_DAY, 18 },
+  { "battery_005", FACE_AT(12, 30, 0), 5, false, true, 8000, 20, WEATHER_CLEAR_DAY, 18 },
+  // steps
+  { "steps_none", FACE_AT(12, 30, 0), 80, false, true, 8000, 0, WEATHER_CLEAR_DAY, 18 },
+  { "steps_half", FACE_AT(15, 0, 0), 80, false, true, 8000, 12, WEATHER_CLEAR_DAY, 18 },
+  { "steps_goal", FACE_AT(17, 0, 0), 80, false, true, 8000, 40, WEATHER_CLEAR_DAY, 18 },
+  // weather states
+  { "weather_none", FACE_AT(12, 30, 0), 80, false, true, 8000, 20, NO_WEATHER, 0 },
+  { "weather_rain", FACE_AT(12, 30, 0), 80, false, true, 8000, 20, WEATHER_RAIN, -3 },
+  { "weather_snow", FACE_AT(12, 30, 0), 80, false, true, 8000, 20, WEATHER_SNOW, -12 },
+  { "weather_fog", FACE_AT(12, 30, 0), 80, false, true, 8000, 20, WEATHER_FOG, 7 },
+  { "weather_wind", FACE_AT(12, 30, 0), 80, false, true, 8000, 20, WEATHER_WIND, 104 },
+  // link and power
+  { "disconnected", FACE_AT(12, 30, 0), 80, false, false, 8000, 20, WEATHER_CLEAR_DAY, 18 },
+  { "low_power", FACE_AT(2, 30, 0), 80, false, true, 8000, 0, WEATHER_CLEAR_NIGHT, 5, false, true },
+};
+
+static bool s_write_golden;
+
+//////////////////////////////////////////
+// launches the face into a scenario    //
+//////////////////////////////////////////
+static void scenario_launch(const Scenario *scenario) {
+  host_init(scenario->time);
+  host_battery(scenario->battery, scenario->charging);
+  host_connection(scenario->connected);
+  host_health_set_sleeping(scenario->sleeping);
+  if(scenario->steps_per_minute && scenario->time - 2 * SECONDS_PER_HOUR > FACE_AT(7, 0, 0)) {
+    host_health_walk(FACE_AT(7, 0, 0), scenario->time - 2 * SECONDS_PER_HOUR, scenario->steps_per_minute);
+  }
+  init();
+  face_name_layers();
+  host_render();
+  face_send_goal(scenario->goal);
+  if(scenario->condition != NO_WEATHER) {
+    face_send_weather(scenario->condition, scenario->temperature, scenario->time - 10 * SECONDS_PER_MINUTE);
+  }
+  if(scenario->tap) {
+    host_tap();
+  }
+}
+
+static int scenario_run(const void *arg) {
+  const Scenario *scenario = arg;
+  scenario_launch(scenario);
+  char golden[256], actual[256];
+  snprintf(golden, sizeof(golden), GOLDEN_DIR "/%s.png", scenario->name);
+  snprintf(actual, sizeof(actual), ACTUAL_DIR "/%s.png", scenario->name);
+  if(s_write_golden) {
+    printf("wrote %s\n", golden);
+    return host_png_write(golden) ? 0 : 1;
+  }
+  int differences = host_png_compare(golden);
+  if(differences == 0) {
+    printf("ok   %s\n", scenario->name);
+    return 0;
+  }
+  host_png_write(actual);
+  if(differences < 0) {
+    printf("FAIL %s: missing or unreadable golden, rendered to %s\n", scenario->name, actual);
+  } else {
+    printf("FAIL %s: %d pixels differ, rendered to %s\n", scenario->name, differences, actual);
+  }
+  return 1;
+}
+
+//////////////////////////////////////////
+// what one frame costs per layer, the  //
+// first frame rasterizes the dial, a   //
+// minute tick blits it from the cache  //
+//////////////////////////////////////////
+static int counters_run(const void *arg) {
+  scenario_launch(&SCENARIOS[0]);
+  face_print_counters(stdout, "launch, dial rasterized");
+  host_reset_counters();
+  host_advance_ms(60 * 1000);
+  face_print_counters(stdout, "minute tick, dial from cache");
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  s_write_golden = argc > 1 && !strcmp(argv[1], "--golden");
+  int failures = 0;
+  for(size_t i=0; i<sizeof(SCENARIOS)/sizeof(SCENARIOS[0]); i++) {
+    failures += face_run_isolated(scenario_run, &SCENARIOS[i]) != 0;
+  }
+  if(!s_write_golden) {
+    failures += face_run_isolated(counters_run, NULL) != 0;
+  }
+  printf("render: %d failed\n", failures);
+  return failures ? 1 : 0;
+}
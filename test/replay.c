@@ -0,0 +1,268 @@
+#include "face.h"
+
+///////////////////////////////////////////////////
+// replays an event trace through the face's     //
+// real handlers at host speed and reports what  //
+// the trace cost: redraws and pixels per layer, //
+// the heap high-water mark and energy per       //
+// subsystem. `replay <trace>`, the format is    //
+// described in test/traces/day.trace            //
+///////////////////////////////////////////////////
+#define MAX_LINE 128
+#define MAX_LAYERS 32
+
+// host rendering has no clock, a frame's cost is estimated from the
+// display flush plus the pixels written, as rough as profile.h's costs
+#define REPLAY_FRAME_MS 2
+#define REPLAY_PIXELS_PER_MS 4000
+
+static const char *CONDITIONS[WEATHER_CONDITION_COUNT] = {
+  "clear_day", "clear_night", "rain", "snow", "sleet", "wind", "fog", "cloudy", "partly_cloudy_day",
+  "partly_cloudy_night"
+};
+
+//////////////////////////////////////////
+// the phone answers weather requests   //
+// with what the trace last set, unless //
+// the link is down                     //
+//////////////////////////////////////////
+typedef struct {
+  bool connected;
+  uint8_t condition;      // WEATHER_CONDITION_UNKNOWN until the trace sets one
+  int16_t temperature;
+  uint32_t answered;      // outbox messages already looked at
+  uint32_t reports;
+} Phone;
+
+static Phone s_phone = { .connected = true, .condition = WEATHER_CONDITION_UNKNOWN };
+
+static void phone_answer() {
+  for(; s_phone.answered<host_outbox_count(); s_phone.answered++) {
+    if(s_phone.connected && s_phone.condition != WEATHER_CONDITION_UNKNOWN &&
+       host_outbox_find(s_phone.answered, KEY_REQUEST_WEATHER)) {
+      face_send_weather(s_phone.condition, s_phone.temperature, host_now());
+      s_phone.reports++;
+    }
+  }
+}
+
+// moves the clock a minute at a time so requests are answered as they go out
+static void replay_advance_to(time_t t) {
+  while(host_now() < t) {
+    host_advance_to(MIN(t, host_now() - host_now() % SECONDS_PER_MINUTE + SECONDS_PER_MINUTE));
+    phone_answer();
+  }
+}
+
+//////////////////////////////////////////
+// one trace line, false if malformed   //
+//////////////////////////////////////////
+static bool parse_time(const char *text, time_t *t) {
+  int hour, minute;
+  if(sscanf(text, "%d:%d", &hour, &minute) != 2 || hour < 0 || hour > 47 || minute < 0 || minute > 59) {
+    return false;
+  }
+  *t = FACE_AT(hour, minute, 0);
+  return true;
+}
+
+static bool replay_event(time_t start, time_t end, const char *event, const char *args) {
+  char word[32] = "";
+  int value = 0;
+  if(!strcmp(event, "walk")) {
+    // steps every minute of the span, each minute a movement event
+    if(sscanf(args, "%d", &value) != 1 || end <= start) {
+      return false;
+    }
+    host_health_walk(start, end, value);
+    for(time_t t=start; t<end; t+=SECONDS_PER_MINUTE) {
+      replay_advance_to(t);
+      host_health_event(HealthEventMovementUpdate);
+    }
+    return true;
+  }
+  if(end != start) {
+    return false;
+  }
+  if(!strcmp(event, "sleep") || !strcmp(event, "wake")) {
+    host_health_set_sleeping(!strcmp(event, "sleep"));
+    host_health_event(HealthEventSleepUpdate);
+  } else if(!strcmp(event, "battery")) {
+    if(sscanf(args, "%d %31s", &value, word) < 1) {
+      return false;
+    }
+    host_battery(value, !strcmp(word, "charging"));
+  } else if(!strcmp(event, "connect") || !strcmp(event, "disconnect")) {
+    s_phone.connected = !strcmp(event, "connect");
+    host_outbox_mode(s_phone.connected ? HOST_OUTBOX_ACK : HOST_OUTBOX_NACK);
+    host_connection(s_phone.connected);
+  } else if(!strcmp(event, "phone")) {
+    if(sscanf(args, "%31s %d", word, &value) != 2) {
+      return false;
+    }
+    s_phone.condition = WEATHER_CONDITION_UNKNOWN;
+    for(int i=0; i<WEATHER_CONDITION_COUNT; i++) {
+      if(!strcmp(word, CONDITIONS[i])) {
+        s_phone.condition = i;
+      }
+    }
+    s_phone.temperature = value;
+    return s_phone.condition != WEATHER_CONDITION_UNKNOWN;
+  } else if(!strcmp(event, "ready")) {
+    face_send_ready();
+  } else if(!strcmp(event, "goal")) {
+    if(sscanf(args, "%d", &value) != 1) {
+      return false;
+    }
+    face_send_goal(value);
+  } else if(!strcmp(event, "tap")) {
+    host_tap();
+  } else if(!strcmp(event, "click")) {
+    host_click(BUTTON_ID_SELECT, sscanf(args, "%31s", word) == 1 && !strcmp(word, "long"));
+  } else if(strcmp(event, "end")) {
+    return false;
+  }
+  phone_answer();
+  return true;
+}
+
+//////////////////////////////////////////
+// launches the face at the first line  //
+// and plays the rest in order          //
+//////////////////////////////////////////
+static int replay_trace(FILE *trace, const char *path, time_t *first, time_t *last) {
+  char line[MAX_LINE];
+  bool launched = false;
+  for(int number=1; fgets(line, sizeof(line), trace); number++) {
+    char *comment = strchr(line, '#');
+    if(comment) {
+      *comment = '\0';
+    }
+    char span[16], event[16];
+    int consumed = 0;
+    if(sscanf(line, "%15s %15s %n", span, event, &consumed) < 2) {
+      continue;
+    }
+    time_t start, end;
+    char *dash = strchr(span, '-');
+    if(dash) {
+      *dash = '\0';
+    }
+    bool valid = parse_time(span, &start);
+    end = start;
+    if(dash) {
+      valid = valid && parse_time(dash + 1, &end);
+    }
+    if(!valid || (launched && start < host_now())) {
+      fprintf(stderr, "%s:%d: bad or out of order time\n", path, number);
+      return 2;
+    }
+    if(!launched) {
+      host_init(start);
+      init();
+      face_name_layers();
+      *first = start;
+      launched = true;
+    }
+    replay_advance_to(start);
+    if(!replay_event(start, end, event, line + consumed)) {
+      fprintf(stderr, "%s:%d: bad event '%s'\n", path, number, event);
+      return 2;
+    }
+    *last = MAX(start, end);
+  }
+  if(!launched) {
+    fprintf(stderr, "%s: no events\n", path);
+    return 2;
+  }
+  return 0;
+}
+
+//////////////////////////////////////////
+// what the replay cost                 //
+//////////////////////////////////////////
+static uint32_t pixels_uj(uint32_t pixels) {
+  return (uint64_t)pixels * ENERGY_UJ_PER_RENDER_MS / REPLAY_PIXELS_PER_MS;
+}
+
+static void report(time_t first, time_t last) {
+  const HostEvents *events = host_events();
+  printf("replayed %u minutes, %u frames, %u weather reports\n\n", (unsigned)(last - first) / SECONDS_PER_MINUTE,
+         events->frames, s_phone.reports);
+
+  HostLayerCounters counters[MAX_LAYERS];
+  int count = host_layer_counters(counters, MAX_LAYERS);
+  uint32_t pixels = 0;
+  printf("  %-16s %8s %8s %8s %8s\n", "layer", "marks", "renders", "pixels", "uJ");
+  for(int i=0; i<count; i++) {
+    printf("  %-16s %8u %8u %8u %8u\n", counters[i].name ? counters[i].name : "-", counters[i].marks,
+           counters[i].renders, counters[i].pixels, pixels_uj(counters[i].pixels));
+    pixels += counters[i].pixels;
+  }
+  printf("  %-16s %8s %8u %8u %8u\n\n", "total", "", events->frames, pixels, pixels_uj(pixels));
+
+  printf("  heap peak %u bytes, %u live at the end, %u in timers\n\n", (unsigned)host_heap_peak(),
+         (unsigned)host_heap_used(HOST_HEAP_OBJECT), (unsigned)host_heap_used(HOST_HEAP_TIMER));
+
+  // the host model next to the on-watch counters from src/profile.c, the
+  // latter only see what the handlers count and time no host renders,
+  // a RELEASE build has no on-watch counters
+  uint32_t wakeups = events->ticks + events->timers + events->health + events->battery + events->connection +
+                     events->taps + events->clicks + events->worker;
+  uint32_t host[PROFILE_ENERGY_COUNT] = {
+    [PROFILE_ENERGY_RENDER] = events->frames * REPLAY_FRAME_MS * ENERGY_UJ_PER_RENDER_MS + pixels_uj(pixels),
+    [PROFILE_ENERGY_WAKEUP] = wakeups * ENERGY_UJ_PER_WAKEUP,
+    [PROFILE_ENERGY_RADIO] = (events->inbox + host_outbox_count()) * ENERGY_UJ_PER_MESSAGE,
+    [PROFILE_ENERGY_VIBE] = events->vibes * ENERGY_UJ_PER_VIBE,
+  };
+  static const char *SUBSYSTEMS[PROFILE_ENERGY_COUNT] = { "render", "wakeup", "radio", "vibe" };
+  uint32_t host_total = 0;
+#if PROFILE_ENABLED
+  uint32_t watch_total = 0;
+  printf("  %-16s %10s %10s\n", "energy uJ", "host", "on-watch");
+  for(int i=0; i<PROFILE_ENERGY_COUNT; i++) {
+    printf("  %-16s %10u %10u\n", SUBSYSTEMS[i], host[i], profile_energy(i));
+    host_total += host[i];
+    watch_total += profile_energy(i);
+  }
+  printf("  %-16s %10u %10u\n", "total", host_total, watch_total);
+#else
+  printf("  %-16s %10s\n", "energy uJ", "host");
+  for(int i=0; i<PROFILE_ENERGY_COUNT; i++) {
+    printf("  %-16s %10u\n", SUBSYSTEMS[i], host[i]);
+    host_total += host[i];
+  }
+  printf("  %-16s %10u\n", "total", host_total);
+#endif
+  printf("  wakeups: %u ticks, %u timers, %u health, %u battery, %u link, %u taps, %u clicks, %u worker\n",
+         events->ticks, events->timers, events->health, events->battery, events->connection, events->taps,
+         events->clicks, events->worker);
+  printf("  radio: %u in, %u out, %u vibes\n", events->inbox, host_outbox_count(), events->vibes);
+}
+
+int main(int argc, char **argv) {
+  if(argc != 2) {
+    fprintf(stderr, "usage: %s <trace>\n", argv[0]);
+    return 2;
+  }
+  FILE *trace = fopen(argv[1], "r");
+  if(!trace) {
+    perror(argv[1]);
+    return 2;
+  }
+  time_t first = 0, last = 0;
+  int result = replay_trace(trace, argv[1], &first, &last);
+  fclose(trace);
+  if(result) {
+    return result;
+  }
+  report(first, last);
+
+  // the window closes cleanly after a full day too
+  deinit();
+  if(host_heap_used(HOST_HEAP_OBJECT)) {
+    printf("FAIL deinit left %u bytes\n", (unsigned)host_heap_used(HOST_HEAP_OBJECT));
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include "host.h"
+#include "scheduler.h"
+
+///////////////////////////////////////////////////
+// drives the weather scheduler minute by minute //
+// against a scripted phone and checks when it   //
+// asks, no two requests are ever closer than    //
+// SCHEDULER_MIN_GAP                             //
+///////////////////////////////////////////////////
+#define START 1000000
+
+typedef enum {
+  PHONE_FRESH,      // acks and answers with data observed now
+  PHONE_STALE,      // acks but only has its old cached report
+  PHONE_FAILING     // every request fails to send
+} Phone;
+
+typedef struct {
+  int requests;
+  int failures;
+  int first;        // minute of the first request, -1 if none
+  int min_gap;      // smallest gap between two requests, minutes
+} Run;
+
+// minutes since START, runs continue where the previous one stopped
+static int s_minute;
+
+static Run run_minutes(Phone phone, int minutes) {
+  Run run = { .first = -1, .min_gap = INT32_MAX };
+  int last = -1;
+  for(int m=1; m<=minutes; m++) {
+    time_t now = START + ++s_minute * SECONDS_PER_MINUTE;
+    if(!scheduler_is_due(now)) {
+      continue;
+    }
+    if(phone == PHONE_FAILING) {
+      scheduler_request_failed(now);
+      run.failures++;
+      continue;
+    }
+    scheduler_request_sent(now);
+    scheduler_request_acked();
+    if(phone == PHONE_FRESH) {
+      scheduler_weather_received(now, now);
+    }
+    run.requests++;
+    if(run.first < 0) {
+      run.first = m;
+    }
+    if(last >= 0 && m - last < run.min_gap) {
+      run.min_gap = m - last;
+    }
+    last = m;
+  }
+  return run;
+}
+
+static int s_failures;
+
+static void expect(bool condition, const char *name, const char *what) {
+  if(!condition) {
+    printf("FAIL %s: %s\n", name, what);
+    s_failures++;
+  }
+}
+
+static void expect_gap(const Run *run, const char *name) {
+  expect(run->requests < 2 || run->min_gap >= SCHEDULER_MIN_GAP, name, "two requests inside the minimum gap");
+}
+
+static void reset(time_t last_observed, uint8_t battery) {
+  s_minute = 0;
+  scheduler_init(last_observed);
+  scheduler_set_base_interval(0);
+  scheduler_set_battery(battery, false);
+}
+
+//////////////////////////////////////////
+// a phone that keeps answering with a  //
+// 4h old cached report, once a storm   //
+// of one request per minute            //
+//////////////////////////////////////////
+static void test_stale_report() {
+  reset(0, 80);
+  scheduler_weather_received(START - 4 * SECONDS_PER_HOUR, START);
+  Run run = run_minutes(PHONE_STALE, 30);
+  printf("     stale report: %d requests in 30 minutes, first at %d\n", run.requests, run.first);
+  expect(run.requests == 1, "stale report", "expected exactly one request in 30 minutes");
+  expect(run.first == SCHEDULER_MIN_GAP, "stale report", "first request not one gap after the report");
+  expect_gap(&run, "stale report");
+}
+
+//////////////////////////////////////////
+// old data on a low battery refreshes  //
+// at the base interval, not stretched  //
+// and not every minute                 //
+//////////////////////////////////////////
+static void test_old_data_low_battery() {
+  reset(0, 15);
+  scheduler_weather_received(START - 4 * SECONDS_PER_HOUR, START);
+  Run run = run_minutes(PHONE_STALE, 2 * 60);
+  int expected = (2 * 60 - SCHEDULER_MIN_GAP) / SCHEDULER_DEFAULT_INTERVAL + 1;
+  printf("     old data, 15%% battery: %d requests in 2 hours\n", run.requests);
+  expect(run.requests == expected, "old data low battery", "expected one request per base interval");
+  expect_gap(&run, "old data low battery");
+}
+
+//////////////////////////////////////////
+// fresh data on a low battery waits    //
+// the stretched interval               //
+//////////////////////////////////////////
+static void test_fresh_low_battery() {
+  reset(START, 15);
+  Run run = run_minutes(PHONE_FRESH, 4 * 60);
+  printf("     fresh data, 15%% battery: %d requests in 4 hours\n", run.requests);
+  expect(run.requests == 2, "fresh low battery", "expected one request per stretched interval");
+  expect(run.first == SCHEDULER_DEFAULT_INTERVAL * 4, "fresh low battery", "first request not one stretched interval in");
+}
+
+//////////////////////////////////////////
+// a battery change while a request is  //
+// waiting for its reply must not make  //
+// it due again                         //
+//////////////////////////////////////////
+static void test_battery_change_in_flight() {
+  reset(START - 2 * SECONDS_PER_HOUR, 80);
+  time_t sent = START + SECONDS_PER_MINUTE;
+  expect(scheduler_is_due(sent), "battery change in flight", "2h old data not due");
+  scheduler_request_sent(sent);
+  scheduler_set_battery(60, true);
+  scheduler_set_battery(40, false);
+  expect(!scheduler_is_due(sent + SECONDS_PER_MINUTE), "battery change in flight", "due again right after sending");
+  expect(scheduler_get_stats()->next_due >= sent + SCHEDULER_DEFAULT_INTERVAL * SECONDS_PER_MINUTE,
+         "battery change in flight", "next due pulled before one interval after the request");
+}
+
+//////////////////////////////////////////
+// failures back off exponentially      //
+//////////////////////////////////////////
+static void test_backoff() {
+  reset(0, 80);
+  Run run = run_minutes(PHONE_FAILING, 2 * 60);
+  // minutes 1, 2, 4, 8, 16, 32 and 64, the next is capped at 60 minutes later
+  printf("     failing phone: %d attempts in 2 hours\n", run.failures);
+  expect(run.failures == 7, "backoff", "expected attempts 1, 2, 4, ... minutes apart");
+}
+
+//////////////////////////////////////////
+// the phone sets the base interval     //
+//////////////////////////////////////////
+static void test_base_interval() {
+  reset(START, 80);
+  scheduler_set_base_interval(60);
+  Run run = run_minutes(PHONE_FRESH, 3 * 60);
+  expect(run.requests == 3 && run.first == 60, "base interval", "expected a request every 60 minutes");
+  // shorter than the minimum gap, the gap wins
+  scheduler_set_base_interval(1);
+  run = run_minutes(PHONE_FRESH, 60);
+  expect(run.requests == 60 / SCHEDULER_MIN_GAP, "base interval", "expected a request every minimum gap");
+  expect_gap(&run, "base interval");
+}
+
+//////////////////////////////////////////
+// only a sent request waits for its    //
+// report, a failure or a report ends   //
+// the wait                             //
+//////////////////////////////////////////
+static void test_pending() {
+  reset(START, 80);
+  time_t now = START + SCHEDULER_DEFAULT_INTERVAL * SECONDS_PER_MINUTE;
+  expect(!scheduler_get_stats()->pending, "pending", "pending before any request");
+  scheduler_request_sent(now);
+  scheduler_request_acked();
+  expect(scheduler_get_stats()->pending, "pending", "acked request no longer waits for its report");
+  scheduler_weather_received(now, now);
+  expect(!scheduler_get_stats()->pending, "pending", "still pending after the report");
+  scheduler_request_sent(now + SCHEDULER_MIN_GAP * SECONDS_PER_MINUTE);
+  scheduler_request_failed(now + SCHEDULER_MIN_GAP * SECONDS_PER_MINUTE);
+  expect(!scheduler_get_stats()->pending, "pending", "still pending after a failure");
+}
+
+int main() {
+  host_init(START);
+  test_stale_report();
+  test_old_data_low_battery();
+  test_fresh_low_battery();
+  test_battery_change_in_flight();
+  test_backoff();
+  test_base_interval();
+  test_pending();
+  printf("scheduler: %d failed\n", s_failures);
+  return s_failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include "host.h"
+
+///////////////////////////////////////////////////
+// the background worker compiled into the test, //
+// walked through a morning to count how often   //
+// it writes storage and what it tells the face  //
+///////////////////////////////////////////////////
+// main() falls off the end, fine for main but not once renamed
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main worker_main
+#include "../worker_src/worker.c"
+#undef main
+#pragma GCC diagnostic pop
+
+// Saturday 2026-03-14 00:00 UTC, the same day the face tests play on
+#define WORKER_DAY 1773446400
+#define WORKER_AT(hour, minute) ((time_t)WORKER_DAY + (hour) * SECONDS_PER_HOUR + (minute) * SECONDS_PER_MINUTE)
+#define WALK_HOURS 3
+
+static int s_failures;
+
+static void expect(bool condition, const char *what) {
+  if(!condition) {
+    printf("FAIL %s\n", what);
+    s_failures++;
+  }
+}
+
+int main() {
+  host_init(WORKER_AT(9, 30));
+  host_health_walk(WORKER_DAY, WORKER_AT(14, 0), 60);
+  init();
+  uint32_t writes = host_persist_writes(PERSIST_KEY_WORKER_STEPS);
+  uint32_t sent = host_worker_sent();
+
+  // moving every minute, the worst case for the old write per update
+  for(int m=0; m<WALK_HOURS * 60; m++) {
+    host_health_event(HealthEventMovementUpdate);
+    host_advance_ms(60 * 1000);
+  }
+  writes = host_persist_writes(PERSIST_KEY_WORKER_STEPS) - writes;
+  sent = host_worker_sent() - sent;
+  printf("     %d hours walking: %u storage writes, %u messages\n", WALK_HOURS, writes, sent);
+  expect(writes == WALK_HOURS, "expected one storage write per hour rollover");
+  // one steps message a minute, plus one per closed hour
+  expect(sent == WALK_HOURS * 60 + WALK_HOURS, "expected a message per minute and per closed hour");
+
+  const AppWorkerMessage *last = host_worker_last();
+  HealthValue hour = health_service_sum(HealthMetricStepCount, WORKER_AT(12, 0), host_now());
+  HealthValue today = health_service_sum_today(HealthMetricStepCount);
+  expect(last->data2 == hour, "last message does not carry the current hour");
+  expect((last->data0 | (HealthValue)last->data1 << 16) == today, "last message does not carry today");
+
+  // the face opening asks for the steps walked since the last message
+  host_advance_ms(30 * 1000);
+  sent = host_worker_sent();
+  host_worker_message(WORKER_MSG_REFRESH, &(AppWorkerMessage) { 0 });
+  last = host_worker_last();
+  today = health_service_sum_today(HealthMetricStepCount);
+  expect(host_worker_sent() == sent + 1 && host_worker_last_type() == WORKER_MSG_STEPS &&
+         (last->data0 | (HealthValue)last->data1 << 16) == today, "refresh request was not answered with today");
+
+  // stopping saves what the messages carried since the last rollover
+  writes = host_persist_writes(PERSIST_KEY_WORKER_STEPS);
+  deinit();
+  WorkerSteps stored;
+  expect(host_persist_writes(PERSIST_KEY_WORKER_STEPS) == writes + 1 &&
+         persist_read_data(PERSIST_KEY_WORKER_STEPS, &stored, sizeof(stored)) == (int)sizeof(stored) &&
+         !memcmp(&stored, &s_steps, sizeof(stored)), "deinit did not store the current steps");
+  printf("worker: %d failed\n", s_failures);
+  return s_failures ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+#include <pebble_worker.h>
+#include "../src/worker_shared.h"
+
+//////////////////////////////////////////////////
+// background worker, keeps today's steps and   //
+// the hourly buckets current while the face is //
+// closed, the face renders what it leaves here //
+//////////////////////////////////////////////////
+static WorkerSteps s_steps;
+// movement seen since the last read, batched into one read per minute
+static bool s_moved;
+
+// local start of the hour containing t
+static time_t worker_hour_start(time_t t, int *hour) {
+  struct tm *local = localtime(&t);
+  *hour = local->tm_hour % WORKER_HOURS;
+  return t - local->tm_min * SECONDS_PER_MINUTE - local->tm_sec;
+}
+
+///////////////////////////////////////////
+// sums every past hour still shown that //
+// the stored buckets do not cover       //
+///////////////////////////////////////////
+static void worker_backfill(time_t now) {
+  int hour;
+  time_t current = worker_hour_start(now, &hour);
+  for(int i=1; i<WORKER_HOURS; i++) {
+    time_t start = current - i * SECONDS_PER_HOUR;
+    StepHour *bucket = &s_steps.hours[(hour + WORKER_HOURS - i) % WORKER_HOURS];
+    if(bucket->start != start) {
+      bucket->start = start;
+      bucket->steps = health_service_sum(HealthMetricStepCount, start, start + SECONDS_PER_HOUR);
+    }
+  }
+}
+
+/////////////////////////////////////////////
+// re-reads today and the current hour,    //
+// closing the previous hour on rollover,  //
+// storage is only written when an hour    //
+// closes, messages carry the rest         //
+/////////////////////////////////////////////
+static void worker_update(time_t now) {
+  int hour;
+  time_t start = worker_hour_start(now, &hour);
+  StepHour *current = &s_steps.hours[hour];
+  bool rollover = current->start != start;
+  StepHour *previous = &s_steps.hours[(hour + WORKER_HOURS - 1) % WORKER_HOURS];
+  bool closed = rollover && previous->start == start - SECONDS_PER_HOUR;
+  if(closed) {
+    // the last minutes of the hour that just ended
+    previous->steps = health_service_sum(HealthMetricStepCount, previous->start, start);
+  }
+  current->start = start;
+  current->steps = health_service_sum(HealthMetricStepCount, start, now);
+  s_steps.steps_today = health_service_sum_today(HealthMetricStepCount);
+  s_steps.day_start = time_start_of_today();
+  s_steps.updated = now;
+  s_moved = false;
+  
+  if(rollover) {
+    persist_write_data(PERSIST_KEY_WORKER_STEPS, &s_steps, sizeof(s_steps));
+  }
+  
+  // dropped by the system when the face is not open
+  if(closed) {
+    AppWorkerMessage closing = { .data0 = MIN(previous->steps, 0xFFFF) };
+    app_worker_send_message(WORKER_MSG_HOUR_CLOSED, &closing);
+  }
+  AppWorkerMessage message = {
+    .data0 = (uint32_t)s_steps.steps_today & 0xFFFF,
+    .data1 = (uint32_t)s_steps.steps_today >> 16,
+    .data2 = MIN(current->steps, 0xFFFF),
+  };
+  app_worker_send_message(WORKER_MSG_STEPS, &message);
+}
+
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+  if(s_moved || (units_changed & HOUR_UNIT)) {
+    worker_update(time(NULL));
+  }
+}
+
+// the face asks for a fresh count when it opens or wakes
+static void app_message_handler(uint16_t type, AppWorkerMessage *message) {
+  if(type == WORKER_MSG_REFRESH) {
+    worker_update(time(NULL));
+  }
+}
+
+static void health_handler(HealthEventType event, void *context) {
+  if(event == HealthEventMovementUpdate) {
+    s_moved = true;
+  }
+}
+
+static void init() {
+  time_t now = time(NULL);
+  if(!persist_exists(PERSIST_KEY_WORKER_STEPS) ||
+     persist_read_data(PERSIST_KEY_WORKER_STEPS, &s_steps, sizeof(s_steps)) != (int)sizeof(s_steps) ||
+     s_steps.version != WORKER_STEPS_VERSION) {
+    memset(&s_steps, 0, sizeof(s_steps));
+    s_steps.version = WORKER_STEPS_VERSION;
+  }
+  worker_backfill(now);
+  worker_update(now);
+  
+  tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+  health_service_events_subscribe(health_handler, NULL);
+  app_worker_message_subscribe(app_message_handler);
+}
+
+static void deinit() {
+  tick_timer_service_unsubscribe();
+  health_service_events_unsubscribe();
+  app_worker_message_unsubscribe();
+  persist_write_data(PERSIST_KEY_WORKER_STEPS, &s_steps, sizeof(s_steps));
+}
+
+int main(void) {
+  init();
+  worker_event_loop();
+  deinit();
+}